@@ -15,10 +15,12 @@ CXX_LIB         := $(abspath $(OBJDIR)/libConsensusCore.a)
 GXX             ?= g++
 
 ifeq ($(GXX),clang++)
+    OPENMP_FLAGS        =
     CXX_FLAGS           = $(CXX_OPT_FLAGS) -msse3 -fPIC -Qunused-arguments -fcolor-diagnostics -fno-omit-frame-pointer
     CXX_STRICT_FLAGS    = $(CXX_FLAGS)
 else
-    CXX_FLAGS           = $(CXX_OPT_FLAGS) $(CXX_EXTRA_ARGS) -msse3 -fPIC -fno-omit-frame-pointer
+    OPENMP_FLAGS        = -fopenmp
+    CXX_FLAGS           = $(CXX_OPT_FLAGS) $(CXX_EXTRA_ARGS) $(OPENMP_FLAGS) -msse3 -fPIC -fno-omit-frame-pointer
     CXX_STRICT_FLAGS    = $(CXX_FLAGS) -pedantic -ansi -Wall
 endif
 
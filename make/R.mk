@@ -21,8 +21,8 @@ $(R_LIB): $(CXX_LIB) $(SWIG_SRCS)
 	$(GSED) -i  s/p_ConsensusCore/p_CC/g $(R_STUB)
 	$(GSED) -i  s/ConsensusCore::/CC::/g $(R_STUB)
 
-	PKG_CXXFLAGS="-Isrc/C++ -I$(BOOST_INCLUDE_PATH)" \
-	PKG_LIBS="$(CXX_LIB)"                            \
+	PKG_CXXFLAGS="-Isrc/C++ -I$(BOOST_INCLUDE_PATH) $(OPENMP_FLAGS)" \
+	PKG_LIBS="$(CXX_LIB) $(OPENMP_FLAGS)"                            \
 	$(R_COMPILE) -o $(R_LIB) $(BUILD_ROOT)/R/ConsensusCore_wrap.cpp
 
 clean-R:
@@ -45,6 +45,6 @@ $(TEST_OBJS) : %.o : %.cpp $(CXX_LIB) $(G_MOCK_LIBRARY) $(G_TEST_LIBRARY) $(G_CP
 	$(CXX) -I$(G_TEST_INCLUDE) -I$(G_MOCK_INCLUDE) -I$(G_CPU_PROFILER_INCLUDE) -c $< -o $@
 
 $(TESTS_EXECUTABLE): $(TEST_OBJS) $(CXX_LIB) $(G_TEST_LIBRARY) $(G_MOCK_LIBRARY) $(G_CPU_PROFILER_LIBRARY) $(G_TEST_MAIN) 
-	$(GXX) --coverage $^ -lpthread -o $@
+	$(GXX) --coverage $(OPENMP_FLAGS) $^ -lpthread -o $@
 
 .PHONY: run-tests tests
@@ -44,17 +44,55 @@ using std::max;
 
 namespace ConsensusCore
 {
+    static bool
+    isValidBase(char base)
+    {
+        return (base == 'A' ||
+                base == 'C' ||
+                base == 'G' ||
+                base == 'T');
+    }
+
     Mutation::Mutation(MutationType type, int position, char base)
         : type_(type),
-          position_(position),
-          base_(base)
-    {
-        if (!(base == 'A' ||
-              base == 'C' ||
-              base == 'G' ||
-              base == 'T' ||
-              base == '-'))
+          start_(position),
+          end_(type == INSERTION ? position : position + 1),
+          newBases_(type == DELETION ? "" : std::string(1, base))
+    {
+        if (!(isValidBase(base) || base == '-'))
             throw InvalidInputError();
+        CheckInvariants();
+    }
+
+    Mutation::Mutation(MutationType type, int start, int end, const std::string& newBases)
+        : type_(type),
+          start_(start),
+          end_(end),
+          newBases_(newBases)
+    {
+        CheckInvariants();
+    }
+
+    void
+    Mutation::CheckInvariants() const
+    {
+        bool valid = (start_ <= end_);
+        switch (type_)
+        {
+            case INSERTION:    valid = valid && start_ == end_ && newBases_.length() > 0;
+                               break;
+            case DELETION:     valid = valid && start_ < end_ && newBases_.length() == 0;
+                               break;
+            case SUBSTITUTION: valid = valid && start_ < end_ &&
+                                       (int)newBases_.length() == end_ - start_;
+                               break;
+            default:           valid = false;
+        }
+        foreach (char base, newBases_)
+        {
+            valid = valid && isValidBase(base);
+        }
+        if (!valid) throw InvalidInputError();
     }
 
     bool
@@ -78,13 +116,31 @@ namespace ConsensusCore
     int
     Mutation::Position() const
     {
-        return position_;
+        return start_;
+    }
+
+    int
+    Mutation::Start() const
+    {
+        return start_;
+    }
+
+    int
+    Mutation::End() const
+    {
+        return end_;
     }
 
     char
     Mutation::Base() const
     {
-        return base_;
+        return IsDeletion() ? '-' : newBases_[0];
+    }
+
+    std::string
+    Mutation::NewBases() const
+    {
+        return newBases_;
     }
 
     MutationType
@@ -95,11 +151,7 @@ namespace ConsensusCore
 
     int Mutation::LengthDiff() const
     {
-        if (IsInsertion())
-            return 1;
-        else if (IsDeletion())
-            return -1;
-        return 0;
+        return newBases_.length() - (end_ - start_);
     }
 
     std::string
@@ -108,46 +160,52 @@ namespace ConsensusCore
         using boost::str;
         using boost::format;
 
-        switch (Type())
+        bool singleBase = (end_ - start_ <= 1 && newBases_.length() <= 1);
+        if (singleBase)
         {
-            case INSERTION:    return str(format("Insertion (%c) @%d") % base_ % position_);
-            case DELETION:     return str(format("Deletion @%d") % position_);
-            case SUBSTITUTION: return str(format("Substitution (%c) @%d") % base_ % position_);
-            default: ShouldNotReachHere();
+            switch (Type())
+            {
+                case INSERTION:    return str(format("Insertion (%c) @%d") % Base() % start_);
+                case DELETION:     return str(format("Deletion @%d") % start_);
+                case SUBSTITUTION: return str(format("Substitution (%c) @%d") % Base() % start_);
+                default: ShouldNotReachHere();
+            }
+        }
+        else
+        {
+            switch (Type())
+            {
+                case INSERTION:    return str(format("Insertion (%s) @%d") % newBases_ % start_);
+                case DELETION:     return str(format("Deletion @%d:%d") % start_ % end_);
+                case SUBSTITUTION: return str(format("Substitution (%s) @%d:%d")
+                                              % newBases_ % start_ % end_);
+                default: ShouldNotReachHere();
+            }
         }
     }
 
     bool
     Mutation::operator==(const Mutation& other) const
     {
-        return (Position() == other.Position() &&
+        return (Start()    == other.Start()    &&
+                End()      == other.End()      &&
                 Type()     == other.Type()     &&
-                Base()     == other.Base());
+                NewBases() == other.NewBases());
     }
 
     bool
     Mutation::operator<(const Mutation& other) const
     {
-        if (Position() != other.Position()) { return Position() < other.Position(); }
+        if (Start()    != other.Start())    { return Start()    < other.Start();    }
         if (Type()     != other.Type())     { return Type()     < other.Type();     }
-        return Base() < other.Base();
+        if (End()      != other.End())      { return End()      < other.End();      }
+        return NewBases() < other.NewBases();
     }
 
     static void
     _ApplyMutationInPlace(const Mutation& mut, int position, std::string* tpl)
     {
-        if (mut.IsSubstitution())
-        {
-            (*tpl)[position] = mut.Base();
-        }
-        else if (mut.IsDeletion())
-        {
-            (*tpl).erase(position, 1);
-        }
-        else if (mut.IsInsertion())
-        {
-            (*tpl).insert(position, 1, mut.Base());
-        }
+        (*tpl).replace(position, mut.End() - mut.Start(), mut.NewBases());
     }
 
     std::string
@@ -196,17 +254,17 @@ namespace ConsensusCore
 
             if (m->IsInsertion())
             {
-                transcript.push_back('I');
+                transcript.append(m->NewBases().length(), 'I');
             }
             else if (m->IsDeletion())
             {
-                transcript.push_back('D');
-                ++tpos;
+                transcript.append(m->End() - m->Start(), 'D');
+                tpos = m->End();
             }
             else if (m->IsSubstitution())
             {
-                transcript.push_back('R');
-                ++tpos;
+                transcript.append(m->End() - m->Start(), 'R');
+                tpos = m->End();
             }
             else
             {
@@ -245,4 +303,51 @@ namespace ConsensusCore
     {
         return TargetToQueryPositions(MutationsToTranscript(mutations, tpl));
     }
+
+    std::vector<Mutation> UniqueSingleBaseMutations(const std::string& tpl,
+                                                    int start,
+                                                    int end,
+                                                    int candidateTypes)
+    {
+        const std::string bases = "ACGT";
+        int tplLength = tpl.length();
+        std::vector<Mutation> mutations;
+        for (int pos = start; pos <= end; pos++)
+        {
+            char prevBase = (pos > 0 ? tpl[pos - 1] : '-');
+            // Insertions of a base already preceding pos are the same as
+            // inserting it earlier in the run.
+            if (candidateTypes & CANDIDATE_INSERTIONS)
+            {
+                foreach (char base, bases)
+                {
+                    if (base != prevBase)
+                    {
+                        mutations.push_back(Mutation(INSERTION, pos, base));
+                    }
+                }
+            }
+            if (pos == end || pos == tplLength)
+            {
+                break;
+            }
+            char curBase = tpl[pos];
+            if (candidateTypes & CANDIDATE_SUBSTITUTIONS)
+            {
+                foreach (char base, bases)
+                {
+                    if (base != curBase)
+                    {
+                        mutations.push_back(Mutation(SUBSTITUTION, pos, base));
+                    }
+                }
+            }
+            // Likewise, only the first base of a run is deleted.
+            if ((candidateTypes & CANDIDATE_DELETIONS) && curBase != prevBase)
+            {
+                mutations.push_back(Mutation(DELETION, pos, '-'));
+            }
+        }
+        return mutations;
+    }
 }
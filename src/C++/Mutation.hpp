@@ -40,15 +40,24 @@ namespace ConsensusCore
     };
 
     /// \brief Single mutation to a template sequence.
+    ///
+    /// A mutation replaces the template span [Start(), End()) with
+    /// NewBases().  Single-base mutations are the special cases where
+    /// the span and/or NewBases() have length one; an insertion has an
+    /// empty span (Start() == End()), and a deletion has empty NewBases().
     class Mutation
     {
     private:
         MutationType type_;
-        int position_;
-        char base_;
+        int start_;
+        int end_;
+        std::string newBases_;
+
+        void CheckInvariants() const;
 
     public:
         Mutation(MutationType type, int position, char base);
+        Mutation(MutationType type, int start, int end, const std::string& newBases);
 
         MutationType Type() const;
         bool IsSubstitution() const;
@@ -60,7 +69,13 @@ namespace ConsensusCore
         /// is that the new base is inserted before Position().
         int Position() const;
 
+        /// \brief Template span [Start(), End()) replaced by the mutation.
+        int Start() const;
+        int End() const;
+
+        /// \brief The first new base, or '-' for a deletion.
         char Base() const;
+        std::string NewBases() const;
 
         int LengthDiff() const;
         std::string ToString() const;
@@ -79,6 +94,26 @@ namespace ConsensusCore
 
     std::vector<int> TargetToQueryPositions(const std::vector<Mutation*>& mutations,
                                             const std::string& tpl);
+
+    /// \brief The kinds of candidate mutations to enumerate
+    enum CandidateMutationTypes
+    {
+        CANDIDATE_SUBSTITUTIONS = 0x1,
+        CANDIDATE_INSERTIONS    = 0x2,
+        CANDIDATE_DELETIONS     = 0x4,
+        ALL_CANDIDATES          = (CANDIDATE_SUBSTITUTIONS |
+                                   CANDIDATE_INSERTIONS    |
+                                   CANDIDATE_DELETIONS)
+    };
+
+    /// \brief The single-base substitutions and deletions of tpl within
+    /// [start, end), and insertions before positions [start, end],
+    /// omitting those equivalent to another in the list (an insertion or
+    /// deletion within a homopolymer run is only tried at its start).
+    std::vector<Mutation> UniqueSingleBaseMutations(const std::string& tpl,
+                                                    int start,
+                                                    int end,
+                                                    int candidateTypes = ALL_CANDIDATES);
 }
 
 
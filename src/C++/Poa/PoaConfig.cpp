@@ -41,30 +41,40 @@ namespace ConsensusCore
         return p;
     }
 
-    void PoaConfig::init(PoaParameterSet params, bool useLocalAlignment, bool useMergeMove)
+    void PoaConfig::init(PoaParameterSet params, bool useLocalAlignment, bool useMergeMove,
+                         int bandwidth)
     {
         this->Params = params;
         this->UseLocalAlignment = useLocalAlignment;
         this->UseMergeMove = useMergeMove;
+        this->Bandwidth = bandwidth;
+        this->PruneInterval = 0;
+        this->PruneFraction = 0.1f;
+    }
+
+    PoaConfig::PoaConfig(PoaParameterSet params, bool useLocalAlignment, bool useMergeMove,
+                         int bandwidth)
+    {
+        init(params, useLocalAlignment, useMergeMove, bandwidth);
     }
 
     PoaConfig::PoaConfig(PoaParameterSet params, bool useLocalAlignment, bool useMergeMove)
     {
-        init(params, useLocalAlignment, useMergeMove);
+        init(params, useLocalAlignment, useMergeMove, 0);
     }
 
     PoaConfig::PoaConfig(PoaParameterSet params, bool useLocalAlignment)
     {
-        init(params, useLocalAlignment, false);
+        init(params, useLocalAlignment, false, 0);
     }
 
     PoaConfig::PoaConfig(bool useLocalAlignment)
     {
-        init(PoaParameterSet::DefaultParameters(), useLocalAlignment, false);
+        init(PoaParameterSet::DefaultParameters(), useLocalAlignment, false, 0);
     }
 
     PoaConfig::PoaConfig()
     {
-        init(PoaParameterSet::DefaultParameters(), false, false);
+        init(PoaParameterSet::DefaultParameters(), false, false, 0);
     }
 }
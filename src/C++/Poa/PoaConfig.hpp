@@ -56,13 +56,25 @@ namespace ConsensusCore
         PoaParameterSet Params;
         bool UseMergeMove;
         bool UseLocalAlignment;
+        // When positive, each sequence is aligned only within this many
+        // read positions of where the alignment runs through the graph
+        // (banded alignment); zero aligns against the whole graph.
+        int Bandwidth;
+        // When positive, the graph is pruned (see PoaGraph::Prune) after
+        // every PruneInterval sequences, of the vertices supported by
+        // fewer than PruneFraction of the sequences spanning them.
+        int PruneInterval;
+        float PruneFraction;
 
+        PoaConfig(PoaParameterSet params, bool useLocalAlignment, bool useMergeMove,
+                  int bandwidth);
         PoaConfig(PoaParameterSet params, bool useLocalAlignment, bool useMergeMove);
         PoaConfig(PoaParameterSet params, bool useLocalAlignment);
         explicit PoaConfig(bool useLocalAlignment);
         PoaConfig();
 
     private:
-        void init(PoaParameterSet params, bool useLocalAlignment, bool useMergeMove);
+        void init(PoaParameterSet params, bool useLocalAlignment, bool useMergeMove,
+                  int bandwidth);
     };
 }
@@ -30,6 +30,9 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/foreach.hpp>
 #include <boost/tuple/tuple.hpp>
+#include <algorithm>
+#include <exception>
+#include <new>
 #include <string>
 #include <utility>
 #include <vector>
@@ -37,10 +40,35 @@
 #include "Poa/PoaConfig.hpp"
 #include "Utils.hpp"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif  // _OPENMP
+
 using boost::tie;
 
 namespace ConsensusCore
 {
+    PoaWindow::PoaWindow()
+        : Start(0),
+          End(0),
+          Reads()
+    {}
+
+    PoaWindow::PoaWindow(int start, int end, const std::vector<std::string>& reads)
+        : Start(start),
+          End(end),
+          Reads(reads)
+    {}
+
+    PoaWindowConsensus::PoaWindowConsensus()
+        : Start(0),
+          End(0),
+          Sequence(),
+          Score(0),
+          Variants(),
+          VariantScores()
+    {}
+
     PoaConsensus::PoaConsensus(const PoaConfig& config)
         : config_(config),
           variants_(NULL)
@@ -75,6 +103,159 @@ namespace ConsensusCore
         return pc;
     }
 
+    static void
+    FindWindowConsensus(PoaGraph& graph, const PoaWindow& window, const PoaConfig& config,
+                        PoaWindowConsensus& result)
+    {
+        graph.Clear();
+        foreach (const std::string& read, window.Reads)
+        {
+            if (read.length() == 0)
+            {
+                throw InvalidInputError("Input sequences must have nonzero length.");
+            }
+            graph.AddSequence(read, config);
+        }
+        std::vector< std::pair<Mutation*, float> >* variants;
+        tie(result.Sequence, result.Score, variants) = graph.FindConsensus(config);
+        result.Start = window.Start;
+        result.End = window.End;
+        result.Variants.clear();
+        result.VariantScores.clear();
+        for (unsigned int k = 0; k < variants->size(); k++)
+        {
+            result.Variants.push_back(*(*variants)[k].first);
+            result.VariantScores.push_back((*variants)[k].second);
+            delete (*variants)[k].first;
+        }
+        delete variants;
+    }
+
+    namespace {
+        // The first exception thrown by any thread of a parallel region,
+        // kept to be rethrown once the region is done, as exceptions
+        // must not leave it.  Lacking exception_ptr, the exceptions the
+        // library throws are copied by type; anything else becomes an
+        // InternalError.
+        class FirstException
+        {
+        public:
+            FirstException()
+                : kind_(NONE),
+                  message_()
+            {}
+
+            // Call from within a catch block.
+            void Capture()
+            {
+                Kind kind;
+                std::string message;
+                try
+                {
+                    throw;
+                }
+                catch (const InvalidInputError& e)
+                {
+                    kind = INVALID_INPUT;
+                    message = e.Message();
+                }
+                catch (const InternalError& e)
+                {
+                    kind = INTERNAL;
+                    message = e.Message();
+                }
+                catch (const NotYetImplementedException&)
+                {
+                    kind = NOT_YET_IMPLEMENTED;
+                }
+                catch (const std::bad_alloc&)
+                {
+                    kind = BAD_ALLOC;
+                }
+                catch (const std::exception& e)
+                {
+                    kind = INTERNAL;
+                    message = e.what();
+                }
+                catch (...)
+                {
+                    kind = INTERNAL;
+                    message = "Unknown exception in parallel region";
+                }
+                #pragma omp critical(FirstException)
+                {
+                    if (kind_ == NONE)
+                    {
+                        kind_ = kind;
+                        message_ = message;
+                    }
+                }
+            }
+
+            void RethrowIfAny() const
+            {
+                switch (kind_)
+                {
+                case INVALID_INPUT:       throw InvalidInputError(message_);
+                case INTERNAL:            throw InternalError(message_);
+                case NOT_YET_IMPLEMENTED: throw NotYetImplementedException();
+                case BAD_ALLOC:           throw std::bad_alloc();
+                default:                  break;
+                }
+            }
+
+        private:
+            enum Kind { NONE, INVALID_INPUT, INTERNAL, NOT_YET_IMPLEMENTED, BAD_ALLOC };
+            Kind kind_;
+            std::string message_;
+        };
+    }
+
+    std::vector<PoaWindowConsensus>
+    PoaConsensus::FindConsensuses(const std::vector<PoaWindow>& windows,
+                                  const PoaConfig& config,
+                                  int numThreads)
+    {
+#ifdef _OPENMP
+        if (numThreads <= 0)
+        {
+            numThreads = omp_get_max_threads();
+        }
+#endif  // _OPENMP
+        numThreads = std::max(1, numThreads);
+
+        // Windows are handed out one at a time, so threads that draw
+        // cheap windows go on to take more of them.
+        std::vector<PoaWindowConsensus> results(windows.size());
+        FirstException error;
+        #pragma omp parallel num_threads(numThreads)
+        {
+            try
+            {
+                PoaGraph graph;
+                #pragma omp for schedule(dynamic)
+                for (int i = 0; i < static_cast<int>(windows.size()); i++)
+                {
+                    try
+                    {
+                        FindWindowConsensus(graph, windows[i], config, results[i]);
+                    }
+                    catch (...)
+                    {
+                        error.Capture();
+                    }
+                }
+            }
+            catch (...)
+            {
+                // constructing the graph failed
+                error.Capture();
+            }
+        }
+        error.RethrowIfAny();
+        return results;
+    }
+
     const PoaConsensus*
     PoaConsensus::FindConsensus(const std::vector<std::string>& reads, bool global)
     {
@@ -39,6 +39,34 @@ namespace ConsensusCore
 {
     using boost::noncopyable;
 
+    /// \brief A window of the reference, and the reads covering it, for
+    /// PoaConsensus::FindConsensuses
+    struct PoaWindow
+    {
+        // Reference coordinates [Start, End); these are not used by the
+        // consensus, only passed through to the result.
+        int Start;
+        int End;
+        std::vector<std::string> Reads;
+
+        PoaWindow();
+        PoaWindow(int start, int end, const std::vector<std::string>& reads);
+    };
+
+    /// \brief The consensus of the reads of a PoaWindow
+    struct PoaWindowConsensus
+    {
+        int Start;
+        int End;
+        std::string Sequence;
+        float Score;
+        // Likely variants of Sequence, and their scores
+        std::vector<Mutation> Variants;
+        std::vector<float> VariantScores;
+
+        PoaWindowConsensus();
+    };
+
     /// \brief A multi-sequence consensus obtained from a partial-order alignment
     class PoaConsensus : private noncopyable
     {
@@ -59,6 +87,16 @@ namespace ConsensusCore
                                                  bool global);
         static const PoaConsensus* FindConsensus(const std::vector<std::string>& reads);
 
+        // The consensus of each of many windows, computed independently
+        // on numThreads threads (or as many as OpenMP offers, if not
+        // positive).  Each thread reuses one graph for all its windows.
+        // Should any window fail, the first exception is rethrown once
+        // all the windows are done.
+        static std::vector<PoaWindowConsensus>
+        FindConsensuses(const std::vector<PoaWindow>& windows,
+                        const PoaConfig& config,
+                        int numThreads = 0);
+
     public:
         const PoaGraph* Graph() const;
         float Score() const;
@@ -29,24 +29,28 @@
 
 #include "Poa/PoaGraph.hpp"
 
-#include <boost/config.hpp>
-#include <boost/foreach.hpp>
+#include <algorithm>
 #include <boost/format.hpp>
-#include <boost/graph/adjacency_list.hpp>
-#include <boost/graph/graphviz.hpp>
-#include <boost/graph/topological_sort.hpp>
+#include <boost/foreach.hpp>
 #include <boost/tuple/tuple.hpp>
 #include <boost/utility.hpp>
 #include <cassert>
+#include <cctype>
 #include <cfloat>
+#include <climits>
+#include <cstring>
+#include <emmintrin.h>
 #include <fstream>
 #include <iostream>
 #include <list>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "Poa/PoaConfig.hpp"
+#include "Quiver/PBFeatures.hpp"
+#include "Quiver/QuiverConfig.hpp"
 #include "Types.hpp"
 #include "Utils.hpp"
 #include "Mutation.hpp"
@@ -57,22 +61,20 @@ using std::pair;
 using std::make_pair;
 using std::cout;
 using std::endl;
-
-///
-///  Boost graph library typedefs, properties, and graphviz output.
-///
-using namespace boost; // NOLINT
-
-namespace boost
-{
-    enum vertex_info_t { vertex_info = 424 };  // a unique #
-    BOOST_INSTALL_PROPERTY(vertex, info);
-}
-
+using boost::format;
+using boost::noncopyable;
+using boost::tuple;
+using boost::make_tuple;
 
 
 namespace ConsensusCore
 {
+    // Vertices are indices into the node array, numbered in order of
+    // creation; ^ and $ are always 0 and 1.
+    typedef int Vertex;
+    typedef std::pair<Vertex, Vertex> Edge;
+    static const Vertex null_vertex = -1;
+
     struct PoaNode
     {
         char Base;
@@ -103,129 +105,497 @@ namespace ConsensusCore
         }
     };
 
-    typedef adjacency_list < hash_setS, vecS, bidirectionalS,
-                             property<vertex_info_t, PoaNode*> > BoostGraph;
-    typedef graph_traits<BoostGraph>::edge_descriptor Edge;
-    typedef graph_traits<BoostGraph>::vertex_descriptor Vertex;
-    typedef property_map<BoostGraph, vertex_info_t>::type VertexInfoMap;
-    static const Vertex null_vertex = graph_traits<BoostGraph>::null_vertex();
-}
+    // Moves reaching a cell of the alignment.  A traceback cell packs
+    // the move (two bits) with the index, in the vertex's predecessor
+    // list, of the vertex the move comes from.  Under local alignment,
+    // row 0 of every vertex can be reached straight from ^ by a Start
+    // move, stored as a Delete from START_INDEX.
+    enum MoveType
+    {
+        MatchMove,
+        MismatchMove,
+        DeleteMove,
+        ExtraMove
+    };
 
+    // Cells are stored straight from the signed 32-bit SSE lanes, so
+    // any in-degree fits.
+    typedef int TracebackCell;
+    static const int MOVE_BITS = 2;
+    static const int MOVE_MASK = 3;
+    static const int START_INDEX = INT_MAX >> MOVE_BITS;
 
-namespace boost
-{
-    using ConsensusCore::VertexInfoMap;
-    using boost::format;
+    static inline TracebackCell
+    packTraceback(int predecessorIndex, MoveType move)
+    {
+        return (predecessorIndex << MOVE_BITS) | move;
+    }
 
-    class my_label_writer
+    // Columns cover read positions 0..I, padded so that rows 1..I can
+    // be processed four at a time.
+    static inline int
+    paddedColumnLength(int readLength)
+    {
+        return 1 + 4 * ((readLength + 3) / 4);
+    }
+
+    // A column holds the rows [BeginRow, EndRow) of the alignment
+    // against one vertex; under banding that is less than the whole
+    // read, and the rows outside it score -FLT_MAX.
+    struct AlignmentColumn
+    {
+        int BeginRow;
+        int EndRow;
+        int BestRow;  // row of the best score (the first, on ties)
+        size_t Offset;  // of row BeginRow in the arena
+
+        bool HasRow(int i) const
+        {
+            return (BeginRow <= i && i < EndRow);
+        }
+    };
+
+    // The alignment columns of a sequence against the graph, laid out
+    // one after another in topological order in a single slab of
+    // scores and a parallel slab of traceback cells.  The slabs are
+    // kept from one sequence to the next, so once they have grown to
+    // fit, aligning a sequence allocates nothing.
+    class AlignmentArena : noncopyable
     {
     public:
-        my_label_writer(VertexInfoMap map, bool color, bool verbose)
-            : map_(map),
-              color_(color),
-              verbose_(verbose)
+        AlignmentArena()
+            : columns_(),
+              scores_(),
+              traceback_(),
+              used_(0)
         {}
 
-        template <class VertexOrEdge>
-        void operator()(std::ostream& out, const VertexOrEdge& v) const
+        void Reset(int numVertices)
         {
-            std::string nodeColoringAttribute =
-                (color_ && map_[v]->IsInConsensus?
-                 " style=\"filled\", fillcolor=\"lightblue\" ," : "");
-            if (!verbose_)
+            columns_.assign(numVertices, AlignmentColumn());
+            used_ = 0;
+        }
+
+        // Lay out the column of v, with all its scores -FLT_MAX.  This
+        // may move the slabs, invalidating pointers into them.
+        const AlignmentColumn& AddColumn(Vertex v, int beginRow, int endRow)
+        {
+            size_t length = endRow - beginRow;
+            if (used_ + length > scores_.size())
             {
-                out << format("[shape=Mrecord,%s label=\"{ %c | %d }\"]")
-                    % nodeColoringAttribute
-                    % map_[v]->Base
-                    % map_[v]->Reads;
+                size_t size = std::max(2 * scores_.size(), used_ + length);
+                scores_.resize(size);
+                traceback_.resize(size);
             }
-            else
+            std::fill(scores_.begin() + used_, scores_.begin() + used_ + length, -FLT_MAX);
+            AlignmentColumn& col = columns_[v];
+            col.BeginRow = beginRow;
+            col.EndRow = endRow;
+            col.BestRow = beginRow;
+            col.Offset = used_;
+            used_ += length;
+            return col;
+        }
+
+        const AlignmentColumn& Column(Vertex v) const
+        {
+            return columns_[v];
+        }
+
+        AlignmentColumn& Column(Vertex v)
+        {
+            return columns_[v];
+        }
+
+        // Scores and traceback of a column, indexed from its BeginRow
+        const float* Scores(const AlignmentColumn& col) const
+        {
+            return &scores_[col.Offset];
+        }
+
+        float* Scores(const AlignmentColumn& col)
+        {
+            return &scores_[col.Offset];
+        }
+
+        const TracebackCell* Traceback(const AlignmentColumn& col) const
+        {
+            return &traceback_[col.Offset];
+        }
+
+        TracebackCell* Traceback(const AlignmentColumn& col)
+        {
+            return &traceback_[col.Offset];
+        }
+
+        float ScoreAt(Vertex v, int i) const
+        {
+            const AlignmentColumn& col = columns_[v];
+            return col.HasRow(i) ? scores_[col.Offset + i - col.BeginRow] : -FLT_MAX;
+        }
+
+    private:
+        vector<AlignmentColumn> columns_;  // indexed by vertex
+        vector<float> scores_;
+        vector<TracebackCell> traceback_;
+        size_t used_;
+    };
+
+    // The scores of the moves aligning a read against a vertex, for
+    // each base the vertex might carry, laid out like an alignment
+    // column (row i is reached by consuming read position i - 1):
+    //   - Scores, Moves: the Match or Mismatch move into row i;
+    //   - MissingScores: the Delete move into row i;
+    //   - ExtraScores: the Extra move into row i, along with the sums
+    //     ExtraPairScores (rows i - 1 and i) and ExtraRampScores (rows
+    //     of i's block of four, up to i) used by the column fill.
+    // Bases the read neither contains nor tags share one slot.
+    class ReadProfile : noncopyable
+    {
+    public:
+        // Flat scores, from the PoaParameterSet
+        ReadProfile(const std::string& sequence, const PoaParameterSet& params)
+            : slotForBase_(256, 0)
+        {
+            const int I = sequence.length();
+            addSlots(sequence, "");
+            for (unsigned int slot = 0; slot < slots_.size(); slot++)
             {
-                out <<  format("[shape=Mrecord,%s label=\"{ "
-                               "{ %d | %c } |"
-                               "{ %d | %d } |"
-                               "{ %0.2f | %0.2f } }\"]")
-                    % nodeColoringAttribute
-                    % v % map_[v]->Base
-                    % map_[v]->Reads % map_[v]->SpanningReads
-                    % map_[v]->Score % map_[v]->ReachingScore;
+                Slot& s = slots_[slot];
+                s.Scores.assign(paddedColumnLength(I), params.Mismatch);
+                s.Moves.assign(paddedColumnLength(I), MismatchMove);
+                s.Missing.assign(paddedColumnLength(I), params.Missing);
+                s.Extra.assign(paddedColumnLength(I), params.Extra);
+                s.ExtraPair.assign(paddedColumnLength(I), 2 * params.Extra);
+                s.ExtraRamp.assign(paddedColumnLength(I), 0);
+                for (int i = 1; i < paddedColumnLength(I); i++)
+                {
+                    if (slot != 0 && i <= I && sequence[i - 1] == s.Base)
+                    {
+                        s.Scores[i] = params.Match;
+                        s.Moves[i] = MatchMove;
+                    }
+                    s.ExtraRamp[i] = ((i - 1) % 4 + 1) * params.Extra;
+                }
+            }
+        }
+
+        // Scores from the read's QVs, computed as QvEvaluator does.
+        // The Extra move is a Branch when the read base repeats the
+        // vertex's.
+        ReadProfile(const QvSequenceFeatures& features, const QvModelParams& params)
+            : slotForBase_(256, 0)
+        {
+            const int I = features.Length();
+            std::string sequence = features.Sequence();
+            std::string delTags(I, '\0');
+            for (int i = 0; i < I; i++)
+            {
+                delTags[i] = static_cast<char>(features.DelTag[i]);
+            }
+            addSlots(sequence, delTags);
+            for (unsigned int slot = 0; slot < slots_.size(); slot++)
+            {
+                Slot& s = slots_[slot];
+                // (Padding rows take the scores of untagged, mismatched bases)
+                s.Scores.assign(paddedColumnLength(I), params.Mismatch);
+                s.Moves.assign(paddedColumnLength(I), MismatchMove);
+                s.Missing.assign(paddedColumnLength(I), params.DeletionN);
+                s.Extra.assign(paddedColumnLength(I), params.Nce);
+                for (int i = 0; i <= I; i++)
+                {
+                    bool isMatch = (i > 0 && slot != 0 && sequence[i - 1] == s.Base);
+                    bool isTagged = (i < I && slot != 0 && delTags[i] == s.Base);
+                    if (i > 0)
+                    {
+                        s.Scores[i] = isMatch ?
+                            params.Match :
+                            params.Mismatch + params.MismatchS * features.SubsQv[i - 1];
+                        s.Moves[i] = isMatch ? MatchMove : MismatchMove;
+                        s.Extra[i] = isMatch ?
+                            params.Branch + params.BranchS * features.InsQv[i - 1] :
+                            params.Nce + params.NceS * features.InsQv[i - 1];
+                    }
+                    if (isTagged)
+                    {
+                        s.Missing[i] = params.DeletionWithTag +
+                                       params.DeletionWithTagS * features.DelQv[i];
+                    }
+                }
+                s.ExtraPair.assign(paddedColumnLength(I), 0);
+                s.ExtraRamp.assign(paddedColumnLength(I), 0);
+                for (int i = 1; i < paddedColumnLength(I); i++)
+                {
+                    s.ExtraPair[i] = s.Extra[i - 1] + s.Extra[i];
+                    s.ExtraRamp[i] = ((i - 1) % 4 == 0 ? 0 : s.ExtraRamp[i - 1]) + s.Extra[i];
+                }
             }
         }
+
+        const float* Scores(char base) const
+        {
+            return &slotFor(base).Scores[0];
+        }
+
+        const int* Moves(char base) const
+        {
+            return &slotFor(base).Moves[0];
+        }
+
+        const float* MissingScores(char base) const
+        {
+            return &slotFor(base).Missing[0];
+        }
+
+        const float* ExtraScores(char base) const
+        {
+            return &slotFor(base).Extra[0];
+        }
+
+        const float* ExtraPairScores(char base) const
+        {
+            return &slotFor(base).ExtraPair[0];
+        }
+
+        const float* ExtraRampScores(char base) const
+        {
+            return &slotFor(base).ExtraRamp[0];
+        }
+
     private:
-        VertexInfoMap map_;
-        bool color_;
-        bool verbose_;
-    };
-}
+        struct Slot
+        {
+            char Base;
+            vector<float> Scores;
+            vector<int> Moves;
+            vector<float> Missing;
+            vector<float> Extra;
+            vector<float> ExtraPair;
+            vector<float> ExtraRamp;
+        };
+
+        // Slot 0, then one slot per distinct base of the given strings
+        void addSlots(const std::string& bases, const std::string& moreBases)
+        {
+            slots_.resize(1);
+            std::string allBases = bases + moreBases;
+            foreach (char base, allBases)
+            {
+                unsigned char b = base;
+                if (slotForBase_[b] != 0) continue;
+                slotForBase_[b] = slots_.size();
+                slots_.push_back(Slot());
+                slots_.back().Base = base;
+            }
+        }
 
+        const Slot& slotFor(char base) const
+        {
+            return slots_[slotForBase_[(unsigned char)base]];
+        }
 
-namespace ConsensusCore
-{
-    enum MoveType
-    {
-        InvalidMove,  // Invalid move reaching ^ (start)
-        StartMove,    // Start move: ^ -> vertex in row 0 of local alignment
-        EndMove,      // End move: vertex -> $ in row 0 of local alignment, or
-                      //  in global alignment, terminal vertex -> $
-        MatchMove,
-        MismatchMove,
-        DeleteMove,
-        ExtraMove
+        vector<int> slotForBase_;
+        vector<Slot> slots_;
     };
 
-    struct AlignmentColumn : noncopyable
+    //
+    // SIMD helpers (four read positions per vector)
+    //
+    static inline __m128
+    select4(__m128 mask, __m128 a, __m128 b)
     {
-        Vertex CurrentVertex;
-        vector<float> Score;
-        vector<MoveType> ReachingMove;
-        vector<Vertex> PreviousVertex;
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
 
-        AlignmentColumn(Vertex vertex, int len)
-            : CurrentVertex(vertex),
-              Score(len, -FLT_MAX),
-              ReachingMove(len, InvalidMove),
-              PreviousVertex(len, null_vertex)
-        {}
+    static inline __m128i
+    select4i(__m128 mask, __m128i a, __m128i b)
+    {
+        __m128i m = _mm_castps_si128(mask);
+        return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+    }
 
-        ~AlignmentColumn()
-        {}
-    };
+    // Scores for rows i..i+3 of a column
+    static inline __m128
+    loadScores4(const AlignmentColumn& col, const float* scores, int i)
+    {
+        if (col.BeginRow <= i && i + 4 <= col.EndRow)
+        {
+            return _mm_loadu_ps(&scores[i - col.BeginRow]);
+        }
+        float rows[4];
+        for (int k = 0; k < 4; k++)
+        {
+            rows[k] = col.HasRow(i + k) ? scores[i + k - col.BeginRow] : -FLT_MAX;
+        }
+        return _mm_loadu_ps(rows);
+    }
+
+    // Shift lanes toward higher rows by one (two), filling with -FLT_MAX
+    static inline __m128
+    shiftUp1(__m128 x)
+    {
+        __m128 fill = _mm_set_ps(0.0f, 0.0f, 0.0f, -FLT_MAX);
+        return _mm_or_ps(_mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 4)), fill);
+    }
 
-    typedef unordered_map<Vertex, const AlignmentColumn*> AlignmentColumnMap;
+    static inline __m128
+    shiftUp2(__m128 x)
+    {
+        __m128 fill = _mm_set_ps(0.0f, 0.0f, -FLT_MAX, -FLT_MAX);
+        return _mm_or_ps(_mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 8)), fill);
+    }
 
     //
     // Graph::Impl methods
     //
 
+    //
+    // Binary serialization: values are written little-endian, four
+    // bytes per int or float, whatever the host.
+    //
+    static const char GRAPH_FILE_MAGIC[4] = { 'P', 'O', 'A', 'G' };
+    static const int GRAPH_FILE_VERSION = 1;
+
+    static void
+    writeInt(std::ostream& out, int value)
+    {
+        unsigned int u = value;
+        char bytes[4] = { static_cast<char>(u), static_cast<char>(u >> 8),
+                          static_cast<char>(u >> 16), static_cast<char>(u >> 24) };
+        out.write(bytes, 4);
+    }
+
+    static void
+    writeFloat(std::ostream& out, float value)
+    {
+        int bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        writeInt(out, bits);
+    }
+
+    static int
+    readInt(std::istream& in)
+    {
+        unsigned char bytes[4];
+        if (!in.read(reinterpret_cast<char*>(bytes), 4))
+        {
+            throw InvalidInputError("Truncated POA graph file");
+        }
+        unsigned int u = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) |
+                         (static_cast<unsigned int>(bytes[3]) << 24);
+        return static_cast<int>(u);
+    }
+
+    static float
+    readFloat(std::istream& in)
+    {
+        int bits = readInt(in);
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    static int
+    readCount(std::istream& in, int limit)
+    {
+        int count = readInt(in);
+        if (count < 0 || count > limit)
+        {
+            throw InvalidInputError("Corrupt POA graph file");
+        }
+        return count;
+    }
+
     class PoaGraph::Impl
     {
-        BoostGraph g_;
-        VertexInfoMap vertexInfoMap_;
+        // The graph is held in flat arrays.  Nodes live contiguously,
+        // indexed by vertex.  Edges are listed in order of insertion,
+        // and indexed in compressed sparse row form: the predecessors
+        // of v are inVertices_[inOffsets_[v], inOffsets_[v+1]), most
+        // recently added first (this decides ties in the alignment and
+        // in the consensus path), and its successors are likewise in
+        // outVertices_, in insertion order.
+        // Edges added while threading a sequence into the graph are
+        // pending until commitEdges() rebuilds the index.
+        //
+        // The topological order is maintained incrementally, as a
+        // doubly linked list running from ^ to $.  Each branch a
+        // sequence adds leaves an existing vertex and rejoins the graph
+        // at a later one, so its new vertices are simply spliced in
+        // ahead of the vertex where it rejoins.
+        vector<PoaNode> nodes_;
+        vector<Edge> edges_;
+        int numCommittedEdges_;
+        vector<int> inOffsets_;
+        vector<Vertex> inVertices_;
+        vector<int> outOffsets_;
+        vector<Vertex> outVertices_;
+        vector<Vertex> nextInOrder_;
+        vector<Vertex> prevInOrder_;
+        AlignmentArena arena_;
+        // Under local alignment, the best score in row I so far, and its
+        // vertex: where the End move to $ comes from
+        float bestEndScore_;
+        Vertex bestEndVertex_;
         Vertex enterVertex_;
         Vertex exitVertex_;
         vector<std::string> sequences_;
 
         void repCheck();
 
+        //
+        // graph representation
+        //
+        int numVertices() const;
+        Vertex addVertex(char base, int reads = 1);
+        void addEdge(Vertex u, Vertex v);
+        int inDegree(Vertex v) const;
+        int outDegree(Vertex v) const;
+        const Vertex* predecessorsBegin(Vertex v) const;
+        const Vertex* predecessorsEnd(Vertex v) const;
+        const Vertex* successorsBegin(Vertex v) const;
+        const Vertex* successorsEnd(Vertex v) const;
+        void commitEdges();
+        void insertBefore(Vertex v, Vertex w);
+        void insertBranch(const vector<Vertex>& branch, Vertex w);
+        void tagSpan(Vertex start, Vertex end);
+        vector<Vertex> maxPath(bool isLocal);
+        vector<Vertex> heaviestPath() const;
+        void removeVertices(const vector<bool>& removed);
+
         //
         // utility routines
         //
-        const AlignmentColumn*
+        void
         makeAlignmentColumn(Vertex v,
-                            const AlignmentColumnMap& alignmentColumnForVertex,
                             const std::string& sequence,
-                            const PoaConfig& config);
+                            const ReadProfile& profile,
+                            const PoaConfig& config,
+                            int bandwidth);
 
-        const AlignmentColumn*
-        makeAlignmentColumnForExit(Vertex v,
-                                   const AlignmentColumnMap& alignmentColumnForVertex,
-                                   const std::string& sequence,
-                                   const PoaConfig& config);
+        Vertex
+        exitPredecessor(const std::string& sequence,
+                        const PoaConfig& config);
+
+        Vertex
+        makeAlignmentColumns(const std::string& sequence,
+                             const ReadProfile& profile,
+                             const PoaConfig& config,
+                             int bandwidth);
+
+        void addSequence(const std::string& sequence,
+                         const ReadProfile& profile,
+                         const PoaConfig& config);
 
     public:
         Impl();
         ~Impl();
         void AddSequence(const std::string& sequence, const PoaConfig& config);
+        void AddSequence(const QvSequenceFeatures& features,
+                         const QvModelParams& qvParams,
+                         const PoaConfig& config);
+        void Clear();
+        int Prune(float minimumFraction);
 
         // TODO(dalexander): make this const
         tuple<string, float, vector< pair<Mutation*, float> >*>
@@ -234,288 +604,476 @@ namespace ConsensusCore
         int NumSequences() const;
         string ToGraphViz(int flags) const;
         void WriteGraphVizFile(string filename, int flags) const;
+        void Save(std::ostream& out) const;
+        void Load(std::istream& in);
     };
 
 
     PoaGraph::Impl::Impl()
+        : numCommittedEdges_(0),
+          bestEndScore_(-FLT_MAX),
+          bestEndVertex_(null_vertex)
     {
-        vertexInfoMap_ = get(vertex_info, g_);
-        enterVertex_ = add_vertex(g_);
-        vertexInfoMap_[enterVertex_] = new PoaNode('^', 0);
-        exitVertex_ = add_vertex(g_);
-        vertexInfoMap_[exitVertex_] = new PoaNode('$', 0);
+        Clear();
     }
 
-    PoaGraph::Impl::~Impl()
+    void
+    PoaGraph::Impl::Clear()
     {
-        foreach (Vertex v, vertices(g_))
-        {
-            delete vertexInfoMap_[v];
-        }
+        // The vectors (and the alignment arena) keep their capacity
+        nodes_.clear();
+        edges_.clear();
+        numCommittedEdges_ = 0;
+        nextInOrder_.clear();
+        prevInOrder_.clear();
+        sequences_.clear();
+
+        enterVertex_ = addVertex('^', 0);
+        exitVertex_ = addVertex('$', 0);
+        nextInOrder_[enterVertex_] = exitVertex_;
+        prevInOrder_[exitVertex_] = enterVertex_;
+        commitEdges();
     }
 
+    PoaGraph::Impl::~Impl()
+    {}
+
     void PoaGraph::Impl::repCheck()
     {
         // assert the representation invariant for the object
-        foreach (Vertex v, vertices(g_))
+        assert(numCommittedEdges_ == (int)edges_.size());
+        vector<int> rank(numVertices(), -1);
+        int k = 0;
+        for (Vertex v = enterVertex_; v != null_vertex; v = nextInOrder_[v])
+        {
+            assert(rank[v] == -1);
+            assert(nextInOrder_[v] == null_vertex || prevInOrder_[nextInOrder_[v]] == v);
+            rank[v] = k++;
+        }
+        assert(k == numVertices());
+        assert(rank[exitVertex_] == k - 1);
+        for (Vertex v = 0; v < numVertices(); v++)
         {
             if (v == enterVertex_)
             {
-                assert(in_degree(v, g_) == 0);
-                assert(out_degree(v, g_) > 0 || NumSequences() == 0);
+                assert(inDegree(v) == 0);
+                assert(outDegree(v) > 0 || NumSequences() == 0);
             }
             else if (v == exitVertex_)
             {
-                assert(in_degree(v, g_) > 0 || NumSequences() == 0);
-                assert(out_degree(v, g_) == 0);
+                assert(inDegree(v) > 0 || NumSequences() == 0);
+                assert(outDegree(v) == 0);
             }
             else
             {
-                assert(in_degree(v, g_) > 0);
-                assert(out_degree(v, g_) > 0);
+                assert(inDegree(v) > 0);
+                assert(outDegree(v) > 0);
+            }
+            for (const Vertex* w = successorsBegin(v); w != successorsEnd(v); ++w)
+            {
+                assert(rank[v] < rank[*w]);
+                assert(std::count(successorsBegin(v), successorsEnd(v), *w) == 1);
             }
-            assert(vertexInfoMap_[v] != NULL);
         }
     }
 
+    inline int
+    PoaGraph::Impl::numVertices() const
+    {
+        return nodes_.size();
+    }
 
-    static inline vector<const AlignmentColumn*>
-    getPredecessorColumns(BoostGraph& g,
-                          Vertex v,
-                          const AlignmentColumnMap& alignmentColumnForVertex)
+    Vertex
+    PoaGraph::Impl::addVertex(char base, int reads)
     {
-        vector<const AlignmentColumn*> predecessorColumns;
-        const AlignmentColumn* predCol;
-        foreach (Edge e, in_edges(v, g))
+        nodes_.push_back(PoaNode(base, reads));
+        nextInOrder_.push_back(null_vertex);
+        prevInOrder_.push_back(null_vertex);
+        return nodes_.size() - 1;
+    }
+
+    void
+    PoaGraph::Impl::addEdge(Vertex u, Vertex v)
+    {
+        // Edges already in the graph are not duplicated.  A single
+        // traceback never adds the same edge twice, so only the
+        // committed edges need checking.
+        if (u < (int)outOffsets_.size() - 1 &&
+            std::find(successorsBegin(u), successorsEnd(u), v) != successorsEnd(u))
         {
-            Vertex u = source(e, g);
-            predCol = alignmentColumnForVertex.at(u);
-            assert(predCol != NULL);
-            predecessorColumns.push_back(predCol);
+            return;
         }
-        return predecessorColumns;
+        edges_.push_back(Edge(u, v));
     }
 
-    const AlignmentColumn*
-    PoaGraph::Impl::makeAlignmentColumnForExit(Vertex v,
-                                               const AlignmentColumnMap& alignmentColumnForVertex,
-                                               const std::string& sequence,
-                                               const PoaConfig& config)
+    inline int
+    PoaGraph::Impl::inDegree(Vertex v) const
     {
-        assert(out_degree(v, g_) == 0);
+        return inOffsets_[v + 1] - inOffsets_[v];
+    }
 
-        // this is kind of unnecessary as we are only actually using one entry in this column
-        int I = sequence.length();
-        AlignmentColumn* curCol = new AlignmentColumn(v, I + 1);
+    inline int
+    PoaGraph::Impl::outDegree(Vertex v) const
+    {
+        return outOffsets_[v + 1] - outOffsets_[v];
+    }
+
+    inline const Vertex*
+    PoaGraph::Impl::predecessorsBegin(Vertex v) const
+    {
+        return &inVertices_[0] + inOffsets_[v];
+    }
+
+    inline const Vertex*
+    PoaGraph::Impl::predecessorsEnd(Vertex v) const
+    {
+        return &inVertices_[0] + inOffsets_[v + 1];
+    }
+
+    inline const Vertex*
+    PoaGraph::Impl::successorsBegin(Vertex v) const
+    {
+        return &outVertices_[0] + outOffsets_[v];
+    }
+
+    inline const Vertex*
+    PoaGraph::Impl::successorsEnd(Vertex v) const
+    {
+        return &outVertices_[0] + outOffsets_[v + 1];
+    }
+
+    void
+    PoaGraph::Impl::commitEdges()
+    {
+        // Rebuild the adjacency index by counting sort on the edge list,
+        // which keeps each vertex's edges in insertion order.
+        // Predecessor lists are then reversed.
+        int V = numVertices();
+        inOffsets_.assign(V + 1, 0);
+        outOffsets_.assign(V + 1, 0);
+        foreach (const Edge& e, edges_)
+        {
+            outOffsets_[e.first + 1]++;
+            inOffsets_[e.second + 1]++;
+        }
+        for (Vertex v = 0; v < V; v++)
+        {
+            outOffsets_[v + 1] += outOffsets_[v];
+            inOffsets_[v + 1] += inOffsets_[v];
+        }
+        // Sentinel entries keep &vertices[0] valid for an edgeless graph
+        inVertices_.assign(edges_.size() + 1, null_vertex);
+        outVertices_.assign(edges_.size() + 1, null_vertex);
+        vector<int> inFill(inOffsets_.begin(), inOffsets_.end() - 1);
+        vector<int> outFill(outOffsets_.begin(), outOffsets_.end() - 1);
+        foreach (const Edge& e, edges_)
+        {
+            outVertices_[outFill[e.first]++] = e.second;
+            inVertices_[inFill[e.second]++] = e.first;
+        }
+        for (Vertex v = 0; v < V; v++)
+        {
+            std::reverse(inVertices_.begin() + inOffsets_[v],
+                         inVertices_.begin() + inOffsets_[v + 1]);
+        }
+        numCommittedEdges_ = edges_.size();
+    }
 
+    void
+    PoaGraph::Impl::insertBefore(Vertex v, Vertex w)
+    {
+        // Splice v into the order just ahead of w
+        assert(w != enterVertex_);
+        Vertex u = prevInOrder_[w];
+        nextInOrder_[u] = v;
+        prevInOrder_[v] = u;
+        nextInOrder_[v] = w;
+        prevInOrder_[w] = v;
+    }
+
+    void
+    PoaGraph::Impl::insertBranch(const vector<Vertex>& branch, Vertex w)
+    {
+        // The branch is listed as threaded, from its last vertex back
+        for (int k = branch.size() - 1; k >= 0; k--)
+        {
+            insertBefore(branch[k], w);
+        }
+    }
+
+    Vertex
+    PoaGraph::Impl::exitPredecessor(const std::string& sequence,
+                                    const PoaConfig& config)
+    {
+        // Only row I matters for $: find where the End move comes from.
+        // Under banding, row I may be out of reach, leaving this null.
+        int I = sequence.length();
         float bestScore = -FLT_MAX;
         Vertex prevVertex = null_vertex;
 
         // Under local alignment the vertex $ can be reached from
         // any other vertex in one step via the End move--not just its
-        // predecessors in the graph
+        // predecessors in the graph.  The best of these was tracked as
+        // the columns were filled.
         if (config.UseLocalAlignment)
         {
-            foreach (Vertex u, vertices(g_))
-            {
-                if (u != exitVertex_)
-                {
-                    const AlignmentColumn* predCol = alignmentColumnForVertex.at(u);
-                    if (predCol->Score[I] > bestScore)
-                    {
-                        bestScore = predCol->Score[I];
-                        prevVertex = predCol->CurrentVertex;
-                    }
-                }
-            }
+            prevVertex = bestEndVertex_;
         }
         else
         {
             // regular predecessors
-            vector<const AlignmentColumn*> predecessorColumns  =
-                    getPredecessorColumns(g_, v, alignmentColumnForVertex);
-            foreach (const AlignmentColumn * predCol, predecessorColumns)
+            for (const Vertex* u = predecessorsBegin(exitVertex_);
+                 u != predecessorsEnd(exitVertex_); ++u)
             {
-                if (predCol->Score[I] > bestScore)
+                if (arena_.ScoreAt(*u, I) > bestScore)
                 {
-                    bestScore = predCol->Score[I];
-                    prevVertex = predCol->CurrentVertex;
+                    bestScore = arena_.ScoreAt(*u, I);
+                    prevVertex = *u;
                 }
             }
         }
-        assert(prevVertex != null_vertex);
-        curCol->Score[I] = bestScore;
-        curCol->PreviousVertex[I] = prevVertex;
-        curCol->ReachingMove[I] = EndMove;
-        return curCol;
+        return prevVertex;
     }
 
 
-    const AlignmentColumn*
+    void
     PoaGraph::Impl::makeAlignmentColumn(Vertex v,
-                                        const AlignmentColumnMap& alignmentColumnForVertex,
                                         const std::string& sequence,
-                                        const PoaConfig& config)
+                                        const ReadProfile& profile,
+                                        const PoaConfig& config,
+                                        int bandwidth)
     {
-        AlignmentColumn* curCol = new AlignmentColumn(v, sequence.length() + 1);
-        const PoaNode* vertexInfo = vertexInfoMap_[v];
-        vector<const AlignmentColumn*> predecessorColumns =
-                getPredecessorColumns(g_, v, alignmentColumnForVertex);
+        const int I = sequence.length();
+        const int numPredecessors = inDegree(v);
+        const Vertex* predecessors = predecessorsBegin(v);
+
+        //
+        // Choose the rows to fill.  Under banding, these are the rows
+        // within bandwidth of where the predecessors' best scores lie,
+        // one row on; the band so follows the alignment down the graph,
+        // widening where predecessors disagree.  Vertices leading to $
+        // extend their band to the end of the read, so that trailing
+        // extra bases can be reached.
+        //
+        int lo = 0, hi = I;
+        if (bandwidth > 0)
+        {
+            if (numPredecessors == 0)
+            {
+                hi = std::min(I, bandwidth);
+            }
+            else
+            {
+                int minBestRow = I, maxBestRow = 0;
+                for (int k = 0; k < numPredecessors; k++)
+                {
+                    int bestRow = arena_.Column(predecessors[k]).BestRow;
+                    minBestRow = std::min(minBestRow, bestRow);
+                    maxBestRow = std::max(maxBestRow, bestRow);
+                }
+                lo = std::max(0, minBestRow + 1 - bandwidth);
+                hi = std::min(I, maxBestRow + 1 + bandwidth);
+            }
+            if (std::find(successorsBegin(v), successorsEnd(v), exitVertex_) !=
+                successorsEnd(v))
+            {
+                hi = I;
+            }
+        }
+        // Whole blocks of four rows, plus the row before the first block
+        int firstBlock = 1 + 4 * (std::max(lo - 1, 0) / 4);
+        int lastBlock = 1 + 4 * (std::max(hi - 1, 0) / 4);
+        const AlignmentColumn& curCol = arena_.AddColumn(v, firstBlock - 1, lastBlock + 4);
+        float* score = arena_.Scores(curCol);
+        TracebackCell* traceback = arena_.Traceback(curCol);
+
+        const float* missingScores = profile.MissingScores(nodes_[v].Base);
 
         //
         // handle read pos 0 separately:
         //
-        if (predecessorColumns.size() == 0)
+        if (curCol.BeginRow > 0)
+        {
+            // read pos 0 is outside the band
+        }
+        else if (numPredecessors == 0)
         {
             // if this vertex doesn't have any in-edges (^), then it has
             // no reaching move
             assert(v == enterVertex_);
-            curCol->Score[0] = 0;
-            curCol->ReachingMove[0] = InvalidMove;
-            curCol->PreviousVertex[0] = null_vertex;
+            score[0] = 0;
         }
         else if (config.UseLocalAlignment)
         {
             // under local alignment, we use the Start move
-            curCol->Score[0] = 0;
-            curCol->ReachingMove[0] = StartMove;
-            curCol->PreviousVertex[0] = enterVertex_;
+            score[0] = 0;
+            traceback[0] = packTraceback(START_INDEX, DeleteMove);
         }
         else
         {
             // otherwise it's a deletion
             float candidateScore;
             float bestScore = -FLT_MAX;
-            Vertex prevVertex = null_vertex;
-            MoveType reachingMove = InvalidMove;
+            int prevIndex = -1;
 
-            foreach (const AlignmentColumn * prevCol, predecessorColumns)
+            for (int k = 0; k < numPredecessors; k++)
             {
-                candidateScore = prevCol->Score[0] + config.Params.Missing;
+                candidateScore = arena_.ScoreAt(predecessors[k], 0) + missingScores[0];
                 if (candidateScore > bestScore)
                 {
                     bestScore = candidateScore;
-                    prevVertex = prevCol->CurrentVertex;
-                    reachingMove = DeleteMove;
+                    prevIndex = k;
                 }
             }
-            assert(reachingMove != InvalidMove);
-            curCol->Score[0] = bestScore;
-            curCol->ReachingMove[0] = reachingMove;
-            curCol->PreviousVertex[0] = prevVertex;
+            assert(prevIndex != -1 || bandwidth > 0);
+            if (prevIndex != -1)
+            {
+                score[0] = bestScore;
+                traceback[0] = packTraceback(prevIndex, DeleteMove);
+            }
         }
 
         //
-        // tackle remainder of read.
+        // tackle remainder of read, four rows at a time.
+        //
+        // For each block, the best Match/Mismatch or Delete move over the
+        // predecessors is found first (visiting them in the same order,
+        // with the same strict comparisons, as a row-at-a-time loop
+        // would).  The Extra move, which chains down the column, is then
+        // applied as a prefix scan:
+        //     Score[i] = max(best[i], Score[i-1] + Extra[i])
+        // carrying Score[i-1] in from the previous block.  Traceback
+        // cells are built in 32-bit lanes.
         //
-        // i represents position in array
-        // readPos=i-1 represents position in read
-        for (unsigned int i = 1, readPos = 0;  i <= sequence.length(); i++, readPos++)
+        const float* matchScores = profile.Scores(nodes_[v].Base);
+        const int* matchMoves = profile.Moves(nodes_[v].Base);
+        const float* extraScores = profile.ExtraScores(nodes_[v].Base);
+        const float* extraPairScores = profile.ExtraPairScores(nodes_[v].Base);
+        const float* extraRampScores = profile.ExtraRampScores(nodes_[v].Base);
+        const __m128i extraMove4 = _mm_set1_epi32(packTraceback(0, ExtraMove));
+        float carry = score[0];
+
+        for (int i = firstBlock; i <= lastBlock; i += 4)
         {
-            float candidateScore;
-            float bestScore = -FLT_MAX;
-            Vertex prevVertex = null_vertex;
-            MoveType reachingMove = InvalidMove;
+            __m128 best = _mm_set_ps1(-FLT_MAX);
+            __m128i trace = _mm_setzero_si128();
+            __m128 missing4 = _mm_loadu_ps(&missingScores[i]);
 
-            foreach (const AlignmentColumn* prevCol, predecessorColumns)
+            for (int k = 0; k < numPredecessors; k++)
             {
+                const AlignmentColumn& prevCol = arena_.Column(predecessors[k]);
+                const float* prevScore = arena_.Scores(prevCol);
+                __m128i index4 = _mm_set1_epi32(k << MOVE_BITS);
+
                 // Incorporate (Match or Mismatch)
-                bool isMatch = sequence[readPos] == vertexInfo->Base;
-                candidateScore = prevCol->Score[i - 1] + (isMatch ?
-                                                             config.Params.Match :
-                                                             config.Params.Mismatch);
-                if (candidateScore > bestScore)
-                {
-                    bestScore = candidateScore;
-                    prevVertex = prevCol->CurrentVertex;
-                    reachingMove = (isMatch ? MatchMove : MismatchMove);
-                }
+                __m128 candidate = _mm_add_ps(loadScores4(prevCol, prevScore, i - 1),
+                                              _mm_loadu_ps(&matchScores[i]));
+                __m128 better = _mm_cmpgt_ps(candidate, best);
+                best = select4(better, candidate, best);
+                __m128i moves4 =
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(&matchMoves[i]));
+                trace = select4i(better, _mm_or_si128(index4, moves4), trace);
+
                 // Delete
-                candidateScore = prevCol->Score[i] + config.Params.Missing;
-                if (candidateScore > bestScore)
-                {
-                    bestScore = candidateScore;
-                    prevVertex = prevCol->CurrentVertex;
-                    reachingMove = DeleteMove;
-                }
+                candidate = _mm_add_ps(loadScores4(prevCol, prevScore, i), missing4);
+                better = _mm_cmpgt_ps(candidate, best);
+                best = select4(better, candidate, best);
+                trace = select4i(better, _mm_set1_epi32(packTraceback(k, DeleteMove)), trace);
             }
+
             // Extra
-            candidateScore = curCol->Score[i - 1] + config.Params.Extra;
-            if (candidateScore > bestScore)
+            __m128 score4 = _mm_max_ps(best, _mm_add_ps(shiftUp1(best),
+                                                        _mm_loadu_ps(&extraScores[i])));
+            score4 = _mm_max_ps(score4, _mm_add_ps(shiftUp2(score4),
+                                                   _mm_loadu_ps(&extraPairScores[i])));
+            score4 = _mm_max_ps(score4, _mm_add_ps(_mm_set_ps1(carry),
+                                                   _mm_loadu_ps(&extraRampScores[i])));
+            __m128 isExtra = _mm_cmpgt_ps(score4, best);
+            trace = select4i(isExtra, extraMove4, trace);
+
+            int r = i - curCol.BeginRow;
+            _mm_storeu_ps(&score[r], score4);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&traceback[r]), trace);
+            carry = score[r + 3];
+        }
+
+        if (config.UseLocalAlignment && curCol.HasRow(I) &&
+            score[I - curCol.BeginRow] > bestEndScore_)
+        {
+            bestEndScore_ = score[I - curCol.BeginRow];
+            bestEndVertex_ = v;
+        }
+
+        if (bandwidth > 0)
+        {
+            int endRow = std::min(curCol.EndRow, I + 1);
+            int bestRow = curCol.BeginRow;
+            for (int i = curCol.BeginRow; i < endRow; i++)
             {
-                bestScore = candidateScore;
-                prevVertex = v;
-                reachingMove = ExtraMove;
+                if (score[i - curCol.BeginRow] > score[bestRow - curCol.BeginRow])
+                {
+                    bestRow = i;
+                }
             }
-            assert(reachingMove != InvalidMove);
-            curCol->Score[i] = bestScore;
-            curCol->ReachingMove[i] = reachingMove;
-            curCol->PreviousVertex[i] = prevVertex;
+            arena_.Column(v).BestRow = bestRow;
         }
+    }
 
-        return curCol;
+    Vertex
+    PoaGraph::Impl::makeAlignmentColumns(const std::string& sequence,
+                                         const ReadProfile& profile,
+                                         const PoaConfig& config,
+                                         int bandwidth)
+    {
+        arena_.Reset(numVertices());
+        bestEndScore_ = -FLT_MAX;
+        bestEndVertex_ = null_vertex;
+        for (Vertex v = enterVertex_; v != exitVertex_; v = nextInOrder_[v])
+        {
+            makeAlignmentColumn(v, sequence, profile, config, bandwidth);
+        }
+        return exitPredecessor(sequence, config);
     }
 
-    static void
-    tagSpan(BoostGraph& g, Vertex start, Vertex end, VertexInfoMap& vertexInfoMap)
+    void
+    PoaGraph::Impl::tagSpan(Vertex start, Vertex end)
     {
         // cout << "Tagging span " << start << " to " << end << endl;
-        std::list<Vertex> sortedVertices(num_vertices(g));
-        topological_sort(g, sortedVertices.rbegin());
-        bool spanning = false;
-        foreach (Vertex v, sortedVertices)
+        for (Vertex v = start; v != end && v != null_vertex; v = nextInOrder_[v])
         {
-            if (v == start)
-            {
-                spanning = true;
-            }
-            if (v == end)
-            {
-                break;
-            }
-            if (spanning)
-            {
-                vertexInfoMap[v]->SpanningReads++;
-            }
+            nodes_[v].SpanningReads++;
         }
     }
 
-    static std::vector<Vertex>
-    maxPath(BoostGraph& g, int totalReads, bool isLocal)
+    vector<Vertex>
+    PoaGraph::Impl::maxPath(bool isLocal)
     {
         std::list<Vertex> path;
-        VertexInfoMap vertexInfoMap = get(vertex_info, g);
-        std::list<Vertex> sortedVertices(num_vertices(g));
-        topological_sort(g, sortedVertices.rbegin());
-        unordered_map<Vertex, Vertex> bestPrevVertex;
+        int totalReads = NumSequences();
+        vector<Vertex> bestPrevVertex(numVertices(), null_vertex);
 
         // ignore ^ and $
-        // TODO(dalexander): find a cleaner way to do this
-        vertexInfoMap[sortedVertices.front()]->ReachingScore = 0;
-        sortedVertices.pop_back();
-        sortedVertices.pop_front();
+        nodes_[enterVertex_].ReachingScore = 0;
 
         Vertex bestVertex = null_vertex;
         float bestReachingScore = -FLT_MAX;
-        foreach (Vertex v, sortedVertices)
+        for (Vertex v = nextInOrder_[enterVertex_]; v != exitVertex_; v = nextInOrder_[v])
         {
-            const PoaNode* vertexInfo = vertexInfoMap[v];
-            int containingReads = vertexInfo->Reads;
-            int spanningReads = vertexInfo->SpanningReads;
+            PoaNode& node = nodes_[v];
+            int containingReads = node.Reads;
+            int spanningReads = node.SpanningReads;
             float score = isLocal ?
                           (2 * containingReads - 1 * spanningReads - 0.0001f) :
                           (2 * containingReads - 1 * totalReads - 0.0001f);
-            vertexInfoMap[v]->Score = score;
-            vertexInfoMap[v]->ReachingScore = score;
-            bestPrevVertex[v] = null_vertex;
-            foreach (Edge e, in_edges(v, g))
-            {
-                Vertex sourceVertex = source(e, g);
-                float rsc = score + vertexInfoMap[sourceVertex]->ReachingScore;
-                if (rsc > vertexInfoMap[v]->ReachingScore)
+            node.Score = score;
+            node.ReachingScore = score;
+            for (const Vertex* u = predecessorsBegin(v); u != predecessorsEnd(v); ++u)
+            {
+                float rsc = score + nodes_[*u].ReachingScore;
+                if (rsc > node.ReachingScore)
                 {
-                    vertexInfoMap[v]->ReachingScore = rsc;
-                    bestPrevVertex[v] = sourceVertex;
+                    node.ReachingScore = rsc;
+                    bestPrevVertex[v] = *u;
                 }
                 if (rsc > bestReachingScore)
                 {
@@ -533,10 +1091,26 @@ namespace ConsensusCore
             path.push_front(v);
             v = bestPrevVertex[v];
         }
-        return std::vector<Vertex>(path.begin(), path.end());
+        return vector<Vertex>(path.begin(), path.end());
     }
 
     void PoaGraph::Impl::AddSequence(const std::string& sequence, const PoaConfig& config)
+    {
+        ReadProfile profile(sequence, config.Params);
+        addSequence(sequence, profile, config);
+    }
+
+    void PoaGraph::Impl::AddSequence(const QvSequenceFeatures& features,
+                                     const QvModelParams& qvParams,
+                                     const PoaConfig& config)
+    {
+        ReadProfile profile(features, qvParams);
+        addSequence(features.Sequence(), profile, config);
+    }
+
+    void PoaGraph::Impl::addSequence(const std::string& sequence,
+                                     const ReadProfile& profile,
+                                     const PoaConfig& config)
     {
         DEBUG_ONLY(repCheck());
         assert(sequence.length() > 0);
@@ -558,16 +1132,16 @@ namespace ConsensusCore
 
             foreach (char base, sequence)
             {
-                v = add_vertex(g_);
-                vertexInfoMap_[v] = new PoaNode(base);
+                v = addVertex(base);
+                insertBefore(v, exitVertex_);
                 if (readPos == 0)
                 {
-                    add_edge(enterVertex_, v, g_);
+                    addEdge(enterVertex_, v);
                     startSpanVertex = v;
                 }
                 else
                 {
-                    add_edge(u, v, g_);
+                    addEdge(u, v);
                 }
                 u = v;
                 readPos++;
@@ -575,82 +1149,83 @@ namespace ConsensusCore
             assert(startSpanVertex != null_vertex);
             assert(u != null_vertex);
             endSpanVertex = u;
-            add_edge(u, exitVertex_, g_);  // terminus -> $
-            tagSpan(g_, startSpanVertex, endSpanVertex, vertexInfoMap_);
+            addEdge(u, exitVertex_);  // terminus -> $
+            commitEdges();
+            tagSpan(startSpanVertex, endSpanVertex);
         }
         else
         {
             // calculate alignment column of sequence vs. graph
-            AlignmentColumnMap alignmentColumnForVertex;
-            vector<Vertex> sortedVertices(num_vertices(g_));
-            topological_sort(g_, sortedVertices.rbegin());
-            const AlignmentColumn* curCol;
-            foreach (Vertex v, sortedVertices)
+            Vertex u = makeAlignmentColumns(sequence, profile, config, config.Bandwidth);
+            if (u == null_vertex)
             {
-                if (v != exitVertex_)
-                {
-                    curCol = makeAlignmentColumn(v, alignmentColumnForVertex,
-                                                 sequence, config);
-                }
-                else
-                {
-                    curCol = makeAlignmentColumnForExit(v, alignmentColumnForVertex,
-                                                        sequence, config);
-                }
-                alignmentColumnForVertex[v] = curCol;
+                // The band lost the alignment; fall back to the full graph
+                u = makeAlignmentColumns(sequence, profile, config, 0);
             }
+            assert(u != null_vertex);
 
             // perform traceback from (I,$), threading the new sequence into the graph as
             // we go.
             int i = I;
             Vertex v = exitVertex_, forkVertex = exitVertex_;
-            Vertex u = alignmentColumnForVertex[exitVertex_]->PreviousVertex[I];
             Vertex startSpanVertex, endSpanVertex = u;
+            // new vertices not yet placed in the order, and where they go
+            vector<Vertex> branch;
+            Vertex branchEnd = null_vertex;
             while ( !(u == enterVertex_ && i == 0) )
             {
                 // u: current vertex
                 // v: vertex last visited in traceback (could be == u)
                 // forkVertex: the vertex that will be the target of a new edge
                 int readPos = i - 1;
-                curCol = alignmentColumnForVertex.at(u);
-                assert(curCol != NULL);
-                PoaNode* curNodeInfo = vertexInfoMap_[u];
-                Vertex prevVertex = curCol->PreviousVertex[i];
-
-                if (curCol->ReachingMove[i] == MatchMove)
+                const AlignmentColumn& curCol = arena_.Column(u);
+                assert(curCol.HasRow(i));
+                TracebackCell cell = arena_.Traceback(curCol)[i - curCol.BeginRow];
+                int reachingMove = cell & MOVE_MASK;
+                int prevIndex = cell >> MOVE_BITS;
+                Vertex prevVertex = (reachingMove == ExtraMove ? u :
+                                     prevIndex == START_INDEX ? enterVertex_ :
+                                     predecessorsBegin(u)[prevIndex]);
+
+                if (reachingMove == MatchMove)
                 {
                     // if there is an extant forkVertex, join it
                     if (forkVertex != null_vertex)
                     {
-                        add_edge(u, forkVertex, g_);
+                        addEdge(u, forkVertex);
                         forkVertex = null_vertex;
                     }
+                    insertBranch(branch, branchEnd);
+                    branch.clear();
                     // add to existing node
-                    curNodeInfo->Reads++;
+                    nodes_[u].Reads++;
                     i--;
                 }
-                else if (curCol->ReachingMove[i] == DeleteMove ||
-                         curCol->ReachingMove[i] == StartMove)
+                else if (reachingMove == DeleteMove)
                 {
                     if (forkVertex == null_vertex)
                     {
                         forkVertex = v;
                     }
                 }
-                else if (curCol->ReachingMove[i] == ExtraMove ||
-                         curCol->ReachingMove[i] == MismatchMove)
+                else if (reachingMove == ExtraMove ||
+                         reachingMove == MismatchMove)
                 {
                     // begin a new arc with this read base
-                    Vertex newForkVertex = add_vertex(g_);
-                    vertexInfoMap_[newForkVertex] = new PoaNode(sequence[readPos]);
+                    Vertex newForkVertex = addVertex(sequence[readPos]);
                     if (forkVertex != null_vertex)
                     {
-                        add_edge(newForkVertex, forkVertex, g_);
+                        addEdge(newForkVertex, forkVertex);
                     }
                     else
                     {
-                        add_edge(newForkVertex, v, g_);
+                        addEdge(newForkVertex, v);
+                    }
+                    if (branch.empty())
+                    {
+                        branchEnd = (forkVertex != null_vertex ? forkVertex : v);
                     }
+                    branch.push_back(newForkVertex);
                     forkVertex = newForkVertex;
                     i--;
                 }
@@ -663,51 +1238,178 @@ namespace ConsensusCore
                 u = prevVertex;
             }
             startSpanVertex = v;
+
+            // The span is tagged before any new leading branch is placed
+            // in the order, so that branch is not counted.
             if (startSpanVertex != exitVertex_)
             {
-                tagSpan(g_, startSpanVertex, endSpanVertex, vertexInfoMap_);
+                tagSpan(startSpanVertex, endSpanVertex);
             }
 
             // if there is an extant forkVertex, join it to enterVertex
             if (forkVertex != null_vertex)
             {
-                add_edge(enterVertex_, forkVertex, g_);
+                addEdge(enterVertex_, forkVertex);
                 forkVertex = null_vertex;
             }
+            insertBranch(branch, branchEnd);
+            commitEdges();
+        }
 
-            // Clean up the mess we created.  Might be nicer to use scoped ptrs.
-            foreach (AlignmentColumnMap::value_type& kv, alignmentColumnForVertex)
-            {
-                delete kv.second;
-            }
+        if (config.PruneInterval > 0 && NumSequences() % config.PruneInterval == 0)
+        {
+            Prune(config.PruneFraction);
         }
 
         DEBUG_ONLY(repCheck());
     }
 
+    vector<Vertex>
+    PoaGraph::Impl::heaviestPath() const
+    {
+        // The path from ^ to $ best supported by the reads, scoring each
+        // vertex by how many more of the reads spanning it contain it
+        // than not (as the local consensus does)
+        vector<int> weight(numVertices(), 0);
+        vector<Vertex> bestPrevVertex(numVertices(), null_vertex);
+        for (Vertex v = nextInOrder_[enterVertex_]; v != null_vertex; v = nextInOrder_[v])
+        {
+            for (const Vertex* u = predecessorsBegin(v); u != predecessorsEnd(v); ++u)
+            {
+                if (bestPrevVertex[v] == null_vertex || weight[*u] > weight[bestPrevVertex[v]])
+                {
+                    bestPrevVertex[v] = *u;
+                }
+            }
+            assert(bestPrevVertex[v] != null_vertex);
+            const PoaNode& node = nodes_[v];
+            weight[v] = weight[bestPrevVertex[v]] + 2 * node.Reads - node.SpanningReads;
+        }
 
-    static boost::unordered_set<Vertex>
-    childVertices(Vertex v,
-                  BoostGraph& g)
+        std::list<Vertex> path;
+        for (Vertex v = exitVertex_; v != null_vertex; v = bestPrevVertex[v])
+        {
+            path.push_front(v);
+        }
+        assert(path.front() == enterVertex_);
+        return vector<Vertex>(path.begin(), path.end());
+    }
+
+    void
+    PoaGraph::Impl::removeVertices(const vector<bool>& removed)
     {
-        boost::unordered_set<Vertex> result;
-        foreach (Edge e, out_edges(v, g))
+        // Renumber the remaining vertices, keeping their relative order
+        // (so ^ and $ keep theirs), and their edges likewise.
+        vector<Vertex> newId(numVertices(), null_vertex);
+        vector<PoaNode> nodes;
+        for (Vertex v = 0; v < numVertices(); v++)
         {
-            result.insert(target(e, g));
+            if (!removed[v])
+            {
+                newId[v] = nodes.size();
+                nodes.push_back(nodes_[v]);
+            }
+        }
+        vector<Edge> edges;
+        foreach (const Edge& e, edges_)
+        {
+            if (!removed[e.first] && !removed[e.second])
+            {
+                edges.push_back(Edge(newId[e.first], newId[e.second]));
+            }
         }
-        return result;
+        vector<Vertex> order;
+        for (Vertex v = enterVertex_; v != null_vertex; v = nextInOrder_[v])
+        {
+            if (!removed[v])
+            {
+                order.push_back(newId[v]);
+            }
+        }
+
+        nodes_.swap(nodes);
+        edges_.swap(edges);
+        numCommittedEdges_ = 0;
+        nextInOrder_.assign(nodes_.size(), null_vertex);
+        prevInOrder_.assign(nodes_.size(), null_vertex);
+        for (unsigned int k = 1; k < order.size(); k++)
+        {
+            nextInOrder_[order[k - 1]] = order[k];
+            prevInOrder_[order[k]] = order[k - 1];
+        }
+        enterVertex_ = newId[enterVertex_];
+        exitVertex_ = newId[exitVertex_];
+        commitEdges();
     }
 
-    static boost::unordered_set<Vertex>
-    parentVertices(Vertex v,
-                   BoostGraph& g)
+    int
+    PoaGraph::Impl::Prune(float minimumFraction)
     {
-        boost::unordered_set<Vertex> result;
-        foreach (Edge e, in_edges(v, g))
+        //
+        // Remove the vertices supported by fewer than minimumFraction of
+        // the reads spanning them--mostly the branches left by sequencing
+        // errors--along with any vertex this cuts off from ^ or $.  The
+        // path from ^ to $ with the most read support is kept whole, so
+        // that the graph stays connected.
+        //
+        int V = numVertices();
+        vector<bool> removed(V, false);
+        vector<bool> kept(V, false);
+        foreach (Vertex v, heaviestPath())
+        {
+            kept[v] = true;
+        }
+
+        vector<Vertex> worklist;
+        for (Vertex v = 0; v < V; v++)
+        {
+            const PoaNode& node = nodes_[v];
+            if (!kept[v] && node.Reads < minimumFraction * node.SpanningReads)
+            {
+                removed[v] = true;
+                worklist.push_back(v);
+            }
+        }
+        if (worklist.empty())
+        {
+            return 0;
+        }
+
+        vector<int> liveInDegree(V), liveOutDegree(V);
+        for (Vertex v = 0; v < V; v++)
         {
-            result.insert(source(e, g));
+            liveInDegree[v] = inDegree(v);
+            liveOutDegree[v] = outDegree(v);
         }
-        return result;
+        int numRemoved = 0;
+        while (!worklist.empty())
+        {
+            Vertex u = worklist.back();
+            worklist.pop_back();
+            numRemoved++;
+            for (const Vertex* w = successorsBegin(u); w != successorsEnd(u); ++w)
+            {
+                if (--liveInDegree[*w] == 0 && !removed[*w])
+                {
+                    assert(!kept[*w]);
+                    removed[*w] = true;
+                    worklist.push_back(*w);
+                }
+            }
+            for (const Vertex* w = predecessorsBegin(u); w != predecessorsEnd(u); ++w)
+            {
+                if (--liveOutDegree[*w] == 0 && !removed[*w])
+                {
+                    assert(!kept[*w]);
+                    removed[*w] = true;
+                    worklist.push_back(*w);
+                }
+            }
+        }
+
+        removeVertices(removed);
+        DEBUG_ONLY(repCheck());
+        return numRemoved;
     }
 
 
@@ -715,12 +1417,12 @@ namespace ConsensusCore
     PoaGraph::Impl::FindConsensus(const PoaConfig& config)
     {
         std::stringstream ss;
-        std::vector<Vertex> bestPath = maxPath(g_, NumSequences(), config.UseLocalAlignment);
+        vector<Vertex> bestPath = maxPath(config.UseLocalAlignment);
         foreach (Vertex v, bestPath)
         {
-            PoaNode* consensusNode = vertexInfoMap_[v];
-            consensusNode->IsInConsensus = true;
-            ss << consensusNode->Base;
+            PoaNode& consensusNode = nodes_[v];
+            consensusNode.IsInConsensus = true;
+            ss << consensusNode.Base;
         }
 
         // if requested, identify likely sequence variants
@@ -733,14 +1435,15 @@ namespace ConsensusCore
             for (int i = 2; i < (int)bestPath.size() - 2; i++) // NOLINT
             {
                 Vertex v = bestPath[i];
-                boost::unordered_set<Vertex> children = childVertices(v, g_);
+                const Vertex* childrenBegin = successorsBegin(v);
+                const Vertex* childrenEnd = successorsEnd(v);
 
                 // Look for a direct edge from the current node to the node
                 // two spaces down---suggesting a deletion with respect to
                 // the consensus sequence.
-                if (children.find(bestPath[i + 2]) != children.end())
+                if (std::find(childrenBegin, childrenEnd, bestPath[i + 2]) != childrenEnd)
                 {
-                    float score = -vertexInfoMap_[bestPath[i + 1]]->Score;
+                    float score = -nodes_[bestPath[i + 1]].Score;
                     variants->push_back(make_pair(new Mutation(DELETION, i + 1, '-'), score));
                 }
 
@@ -748,31 +1451,28 @@ namespace ConsensusCore
                 // This indicates we should try inserting the base at i + 1.
 
                 // Parents of (i + 1)
-                boost::unordered_set<Vertex> lookBack = parentVertices(bestPath[i + 1], g_);
+                const Vertex* lookBackBegin = predecessorsBegin(bestPath[i + 1]);
+                const Vertex* lookBackEnd = predecessorsEnd(bestPath[i + 1]);
 
-                // (We could do this in STL using std::set sorted on score, which would then
-                // provide an intersection mechanism (in <algorithm>) but that actually ends
-                // up being more code.  Sad.)
                 float bestInsertScore = -FLT_MAX;
                 Vertex bestInsertVertex = null_vertex;
 
-                foreach (Vertex v, children)
+                for (const Vertex* c = childrenBegin; c != childrenEnd; ++c)
                 {
-                    boost::unordered_set<Vertex>::iterator found = lookBack.find(v);
-                    if (found != lookBack.end())
+                    if (std::find(lookBackBegin, lookBackEnd, *c) != lookBackEnd)
                     {
-                        float score = vertexInfoMap_[*found]->Score;
+                        float score = nodes_[*c].Score;
                         if (score > bestInsertScore)
                         {
                             bestInsertScore = score;
-                            bestInsertVertex = *found;
+                            bestInsertVertex = *c;
                         }
                     }
                 }
 
                 if (bestInsertVertex != null_vertex)
                 {
-                    char base = vertexInfoMap_[bestInsertVertex]->Base;
+                    char base = nodes_[bestInsertVertex].Base;
                     variants->push_back(
                             make_pair(new Mutation(INSERTION, i + 1, base), bestInsertScore));
                 }
@@ -781,23 +1481,23 @@ namespace ConsensusCore
                 // to i + 2.  This indicates we should try mismatching the base i + 1.
 
                 // Parents of (i + 2)
-                lookBack = parentVertices(bestPath[i + 2], g_);
+                lookBackBegin = predecessorsBegin(bestPath[i + 2]);
+                lookBackEnd = predecessorsEnd(bestPath[i + 2]);
 
                 float bestMismatchScore = -FLT_MAX;
                 Vertex bestMismatchVertex = null_vertex;
 
-                foreach (Vertex v, children)
+                for (const Vertex* c = childrenBegin; c != childrenEnd; ++c)
                 {
-                    if (v == bestPath[i + 1]) continue;
+                    if (*c == bestPath[i + 1]) continue;
 
-                    boost::unordered_set<Vertex>::iterator found = lookBack.find(v);
-                    if (found != lookBack.end())
+                    if (std::find(lookBackBegin, lookBackEnd, *c) != lookBackEnd)
                     {
-                        float score = vertexInfoMap_[*found]->Score;
+                        float score = nodes_[*c].Score;
                         if (score > bestMismatchScore)
                         {
                             bestMismatchScore = score;
-                            bestMismatchVertex = *found;
+                            bestMismatchVertex = *c;
                         }
                     }
                 }
@@ -807,7 +1507,7 @@ namespace ConsensusCore
                     // TODO(dalexander): As implemented (compatibility), this returns
                     // the score of the mismatch node. I think it should return the score
                     // difference, no?
-                    char base = vertexInfoMap_[bestMismatchVertex]->Base;
+                    char base = nodes_[bestMismatchVertex].Base;
                     variants->push_back(
                             make_pair(new Mutation(SUBSTITUTION, i + 1, base), bestMismatchScore));
                 }
@@ -825,10 +1525,44 @@ namespace ConsensusCore
 
     string PoaGraph::Impl::ToGraphViz(int flags) const
     {
+        // Same layout as boost::write_graphviz: vertices in index order,
+        // then edges in order of insertion.
+        bool color = flags & COLOR_NODES;
+        bool verbose = flags & VERBOSE_NODES;
         std::stringstream ss;
-        write_graphviz(ss, g_, my_label_writer(vertexInfoMap_,
-                                               flags & COLOR_NODES,
-                                               flags & VERBOSE_NODES));
+        ss << "digraph G {" << endl;
+        for (Vertex v = 0; v < numVertices(); v++)
+        {
+            const PoaNode& node = nodes_[v];
+            std::string nodeColoringAttribute =
+                (color && node.IsInConsensus ?
+                 " style=\"filled\", fillcolor=\"lightblue\" ," : "");
+            ss << v;
+            if (!verbose)
+            {
+                ss << format("[shape=Mrecord,%s label=\"{ %c | %d }\"]")
+                    % nodeColoringAttribute
+                    % node.Base
+                    % node.Reads;
+            }
+            else
+            {
+                ss <<  format("[shape=Mrecord,%s label=\"{ "
+                              "{ %d | %c } |"
+                              "{ %d | %d } |"
+                              "{ %0.2f | %0.2f } }\"]")
+                    % nodeColoringAttribute
+                    % v % node.Base
+                    % node.Reads % node.SpanningReads
+                    % node.Score % node.ReachingScore;
+            }
+            ss << ";" << endl;
+        }
+        foreach (const Edge& e, edges_)
+        {
+            ss << e.first << "->" << e.second << " ;" << endl;
+        }
+        ss << "}" << endl;
         return ss.str();
     }
 
@@ -841,6 +1575,178 @@ namespace ConsensusCore
         outfile.close();
     }
 
+    void
+    PoaGraph::Impl::Save(std::ostream& out) const
+    {
+        // Layout: magic, version; then the vertices (base, flags, read
+        // counts and consensus scores); the topological order; the
+        // edges, in insertion order; and the sequences.
+        out.write(GRAPH_FILE_MAGIC, 4);
+        writeInt(out, GRAPH_FILE_VERSION);
+
+        writeInt(out, numVertices());
+        foreach (const PoaNode& node, nodes_)
+        {
+            out.put(node.Base);
+            out.put(node.IsInConsensus ? 1 : 0);
+            writeInt(out, node.Reads);
+            writeInt(out, node.SpanningReads);
+            writeFloat(out, node.Score);
+            writeFloat(out, node.ReachingScore);
+        }
+        for (Vertex v = enterVertex_; v != null_vertex; v = nextInOrder_[v])
+        {
+            writeInt(out, v);
+        }
+
+        writeInt(out, edges_.size());
+        foreach (const Edge& e, edges_)
+        {
+            writeInt(out, e.first);
+            writeInt(out, e.second);
+        }
+
+        writeInt(out, sequences_.size());
+        foreach (const std::string& sequence, sequences_)
+        {
+            writeInt(out, sequence.length());
+            out.write(sequence.data(), sequence.length());
+        }
+    }
+
+    void
+    PoaGraph::Impl::Load(std::istream& in)
+    {
+        char magic[4];
+        if (!in.read(magic, 4) || !std::equal(magic, magic + 4, GRAPH_FILE_MAGIC))
+        {
+            throw InvalidInputError("Not a POA graph file");
+        }
+        if (readInt(in) != GRAPH_FILE_VERSION)
+        {
+            throw InvalidInputError("Unsupported POA graph file version");
+        }
+
+        // Read into a fresh graph, so that this one is untouched if the
+        // input turns out to be corrupt.
+        Impl g;
+        g.nodes_.clear();
+        int V = readCount(in, INT_MAX);
+        if (V < 2)
+        {
+            throw InvalidInputError("Corrupt POA graph file");
+        }
+        for (int v = 0; v < V; v++)
+        {
+            // ^ and $ are the first two vertices; every other vertex
+            // carries a printable base, and the flag is 0 or 1
+            int base = in.get();
+            int isInConsensus = in.get();
+            bool isBase = (base != EOF && std::isgraph(base) && base != '^' && base != '$');
+            if (v == g.enterVertex_ ? base != '^' :
+                v == g.exitVertex_  ? base != '$' : !isBase)
+            {
+                throw InvalidInputError("Corrupt POA graph file");
+            }
+            if (isInConsensus != 0 && isInConsensus != 1)
+            {
+                throw InvalidInputError("Corrupt POA graph file");
+            }
+            PoaNode node(static_cast<char>(base), readInt(in));
+            node.IsInConsensus = (isInConsensus == 1);
+            node.SpanningReads = readInt(in);
+            node.Score = readFloat(in);
+            node.ReachingScore = readFloat(in);
+            g.nodes_.push_back(node);
+        }
+
+        // The order must run from ^ to $ through every vertex, once
+        vector<int> rank(V, -1);
+        g.nextInOrder_.assign(V, null_vertex);
+        g.prevInOrder_.assign(V, null_vertex);
+        Vertex u = null_vertex;
+        for (int k = 0; k < V; k++)
+        {
+            Vertex v = readCount(in, V - 1);
+            if (rank[v] != -1 || (k == 0) != (v == g.enterVertex_) ||
+                (k == V - 1) != (v == g.exitVertex_))
+            {
+                throw InvalidInputError("Corrupt POA graph file");
+            }
+            rank[v] = k;
+            if (u != null_vertex)
+            {
+                g.nextInOrder_[u] = v;
+                g.prevInOrder_[v] = u;
+            }
+            u = v;
+        }
+
+        // Edges must follow the order, and (unless the graph is empty,
+        // just ^ and $) every vertex but ^ must be reached by one, and
+        // every vertex but $ left by one
+        int E = readCount(in, INT_MAX);
+        vector<bool> hasPredecessor(V, false), hasSuccessor(V, false);
+        for (int k = 0; k < E; k++)
+        {
+            Vertex from = readCount(in, V - 1);
+            Vertex to = readCount(in, V - 1);
+            if (rank[from] >= rank[to])
+            {
+                throw InvalidInputError("Corrupt POA graph file");
+            }
+            hasSuccessor[from] = true;
+            hasPredecessor[to] = true;
+            g.edges_.push_back(Edge(from, to));
+        }
+        for (Vertex v = 0; v < V && V > 2; v++)
+        {
+            if ((v != g.enterVertex_ && !hasPredecessor[v]) ||
+                (v != g.exitVertex_ && !hasSuccessor[v]))
+            {
+                throw InvalidInputError("Corrupt POA graph file");
+            }
+        }
+
+        // Sequences are read in bounded chunks, so that a corrupt length
+        // runs into the end of the input rather than allocating it all.
+        int numSequences = readCount(in, INT_MAX);
+        for (int k = 0; k < numSequences; k++)
+        {
+            int length = readCount(in, INT_MAX);
+            if (length == 0)
+            {
+                throw InvalidInputError("Corrupt POA graph file");
+            }
+            std::string sequence;
+            char chunk[4096];
+            while (static_cast<int>(sequence.length()) < length)
+            {
+                int n = std::min(length - static_cast<int>(sequence.length()),
+                                 static_cast<int>(sizeof(chunk)));
+                if (!in.read(chunk, n))
+                {
+                    throw InvalidInputError("Truncated POA graph file");
+                }
+                sequence.append(chunk, n);
+            }
+            g.sequences_.push_back(sequence);
+        }
+        if (!in)
+        {
+            throw InvalidInputError("Truncated POA graph file");
+        }
+
+        nodes_.swap(g.nodes_);
+        edges_.swap(g.edges_);
+        nextInOrder_.swap(g.nextInOrder_);
+        prevInOrder_.swap(g.prevInOrder_);
+        sequences_.swap(g.sequences_);
+        numCommittedEdges_ = 0;
+        commitEdges();
+        DEBUG_ONLY(repCheck());
+    }
+
     // PIMPL idiom delegation
 
     void
@@ -849,6 +1755,26 @@ namespace ConsensusCore
         impl->AddSequence(sequence, config);
     }
 
+    void
+    PoaGraph::AddSequence(const QvSequenceFeatures& features,
+                          const QvModelParams& qvParams,
+                          const PoaConfig& config)
+    {
+        impl->AddSequence(features, qvParams, config);
+    }
+
+    void
+    PoaGraph::Clear()
+    {
+        impl->Clear();
+    }
+
+    int
+    PoaGraph::Prune(float minimumFraction)
+    {
+        return impl->Prune(minimumFraction);
+    }
+
     int
     PoaGraph::NumSequences() const
     {
@@ -873,6 +1799,45 @@ namespace ConsensusCore
         impl->WriteGraphVizFile(filename, flags);
     }
 
+    void
+    PoaGraph::Save(std::ostream& out) const
+    {
+        impl->Save(out);
+    }
+
+    void
+    PoaGraph::Load(std::istream& in)
+    {
+        impl->Load(in);
+    }
+
+    void
+    PoaGraph::WriteBinaryFile(std::string filename) const
+    {
+        std::ofstream outfile(filename.c_str(), std::ios::binary);
+        if (!outfile)
+        {
+            throw InvalidInputError("Cannot open POA graph file: " + filename);
+        }
+        impl->Save(outfile);
+        outfile.close();
+        if (!outfile)
+        {
+            throw InvalidInputError("Cannot write POA graph file: " + filename);
+        }
+    }
+
+    void
+    PoaGraph::ReadBinaryFile(std::string filename)
+    {
+        std::ifstream infile(filename.c_str(), std::ios::binary);
+        if (!infile)
+        {
+            throw InvalidInputError("Cannot open POA graph file: " + filename);
+        }
+        impl->Load(infile);
+    }
+
     PoaGraph::PoaGraph()
     {
         impl = new Impl();
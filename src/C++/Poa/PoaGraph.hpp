@@ -28,6 +28,7 @@
 #pragma once
 
 #include <boost/tuple/tuple.hpp>
+#include <iosfwd>
 #include <vector>
 #include <string>
 #include <utility>
@@ -52,6 +53,22 @@ namespace ConsensusCore
     public:
         void AddSequence(const std::string& sequence, const PoaConfig& config);
 
+        // Add a read, scoring its alignment to the graph with move costs
+        // from its QVs, as QvEvaluator does, in place of config.Params.
+        void AddSequence(const QvSequenceFeatures& features,
+                         const QvModelParams& qvParams,
+                         const PoaConfig& config);
+
+        // Remove all sequences, leaving an empty graph.  The memory
+        // allocated so far is kept, for reuse by the next sequences.
+        void Clear();
+
+        // Remove the vertices supported by fewer than minimumFraction of
+        // the sequences spanning them, and any left disconnected by
+        // their removal; returns the number removed.  Vertices are
+        // renumbered.
+        int Prune(float minimumFraction);
+
         // TODO(dalexander): move this method to PoaConsensus so we don't have to use a tuple
         // interface here (which was done to avoid a circular dep on PoaConsensus).
 #ifndef SWIG
@@ -62,6 +79,20 @@ namespace ConsensusCore
         int NumSequences() const;
         std::string ToGraphViz(int flags = 0) const;
         void WriteGraphVizFile(std::string filename, int flags = 0) const;
+
+        // Compact binary form of the graph--its vertices with their read
+        // counts, edges, order and sequences--from which it can be
+        // restored exactly and extended with more sequences.  Loading
+        // replaces the graph's content; corrupt input throws
+        // InvalidInputError, leaving the graph as it was.  Failing to
+        // open or write the file in WriteBinaryFile throws
+        // InvalidInputError too.
+#ifndef SWIG
+        void Save(std::ostream& out) const;
+        void Load(std::istream& in);
+#endif  // !SWIG
+        void WriteBinaryFile(std::string filename) const;
+        void ReadBinaryFile(std::string filename);
         PoaGraph();
         ~PoaGraph();
     };
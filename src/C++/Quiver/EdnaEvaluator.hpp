@@ -42,6 +42,7 @@
 #include "LFloat.hpp"
 #include "Quiver/EdnaConfig.hpp"
 #include "Quiver/PBFeatures.hpp"
+#include "Quiver/TemplateView.hpp"
 #include "Types.hpp"
 #include "Utils.hpp"
 
@@ -69,7 +70,7 @@ namespace ConsensusCore
             : features_(features),
               params_(params),
               tpl_(tpl),
-              channelTpl_(channelTpl, tpl_.length()),
+              channelTpl_(channelTpl, tpl_.Length()),
               pinStart_(true),
               pinEnd_(true)
         {}
@@ -84,13 +85,25 @@ namespace ConsensusCore
 
         std::string Template() const
         {
-            return tpl_;
+            return tpl_.ToString();
         }
 
         void Template(std::string tpl)
+        {
+            tpl_ = TemplateView(tpl);
+        }
+
+#ifndef SWIG
+        const TemplateView& TemplateRef() const
+        {
+            return tpl_;
+        }
+
+        void Template(const TemplateView& tpl)
         {
             tpl_ = tpl;
         }
+#endif  // SWIG
 
         int ReadLength() const
         {
@@ -99,7 +112,7 @@ namespace ConsensusCore
 
         int TemplateLength() const
         {
-            return tpl_.length();
+            return tpl_.Length();
         }
 
         bool PinEnd() const
@@ -306,7 +319,7 @@ namespace ConsensusCore
     protected:
         ChannelSequenceFeatures features_;
         EdnaModelParams params_;
-        std::string tpl_;
+        TemplateView tpl_;
         Feature<int> channelTpl_;
         bool pinStart_;
         bool pinEnd_;
@@ -25,9 +25,13 @@
 
 // Author: David Alexander
 
+#include <algorithm>
 #include <cfloat>
+#include <cmath>
+#include <functional>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "Mutation.hpp"
@@ -35,14 +39,109 @@
 #include "Quiver/MultiReadMutationScorer.hpp"
 #include "Utils.hpp"
 
-#define MARGIN 3
+#ifdef _OPENMP
+#include <omp.h>
+#endif  // _OPENMP
+
+// FastScore and FastIsFavorable only stop early once the bound on the
+// total score is BOUND_TOLERANCE below their cutoff, so that rounding
+// can't make them disagree with Score and IsFavorable.
+#define BOUND_TOLERANCE 0.01
+
+// Highest consensus QV reported.
+#define MAX_CONSENSUS_QV 93
+
+using std::max;
+using std::min;
 
 namespace ConsensusCore
 {
-    static bool readScoresPosition(const MappedRead* read, int position)
+    // Orders read slots by template start, then by read ID.
+    class ReadSlotLessThan
+    {
+    public:
+        ReadSlotLessThan(const std::vector<int>& templateStarts,
+                         const std::vector<int>& readIds)
+            : templateStarts_(templateStarts),
+              readIds_(readIds)
+        {}
+
+        bool operator()(int slot1, int slot2) const
+        {
+            return (templateStarts_[slot1] < templateStarts_[slot2] ||
+                    (templateStarts_[slot1] == templateStarts_[slot2] &&
+                     readIds_[slot1] < readIds_[slot2]));
+        }
+
+    private:
+        const std::vector<int>& templateStarts_;
+        const std::vector<int>& readIds_;
+    };
+
+    // Orders read slots by decreasing template span, then by decreasing
+    // alignment score, then by read ID.
+    class ReadRankGreaterThan
+    {
+    public:
+        ReadRankGreaterThan(const std::vector<int>& templateStarts,
+                            const std::vector<int>& templateEnds,
+                            const std::vector<float>& readScores,
+                            const std::vector<int>& readIds)
+            : templateStarts_(templateStarts),
+              templateEnds_(templateEnds),
+              readScores_(readScores),
+              readIds_(readIds)
+        {}
+
+        bool operator()(int slot1, int slot2) const
+        {
+            int span1 = templateEnds_[slot1] - templateStarts_[slot1];
+            int span2 = templateEnds_[slot2] - templateStarts_[slot2];
+            if (span1 != span2) return span1 > span2;
+            if (readScores_[slot1] != readScores_[slot2])
+            {
+                return readScores_[slot1] > readScores_[slot2];
+            }
+            return readIds_[slot1] < readIds_[slot2];
+        }
+
+    private:
+        const std::vector<int>& templateStarts_;
+        const std::vector<int>& templateEnds_;
+        const std::vector<float>& readScores_;
+        const std::vector<int>& readIds_;
+    };
+
+    // Swaps rather than copies the elements into place, as they may be
+    // large.
+    template<typename T>
+    static void permute(std::vector<T>& v, const std::vector<int>& order)
+    {
+        std::vector<T> permuted(v.size());
+        for (int i = 0; i < static_cast<int>(order.size()); i++)
+        {
+            std::swap(permuted[i], v[order[i]]);
+        }
+        v.swap(permuted);
+    }
+
+    static void permute(std::vector<bool>& v, const std::vector<int>& order)
     {
-        return (read->TemplateStart + MARGIN <= position &&
-                read->TemplateEnd   - MARGIN > position);
+        std::vector<bool> permuted(v.size());
+        for (int i = 0; i < static_cast<int>(order.size()); i++)
+        {
+            permuted[i] = v[order[i]];
+        }
+        v.swap(permuted);
+    }
+
+    // Whether any of the counts in [first, last) has reached limit.
+    static bool anyAtLimit(std::vector<int>::const_iterator first,
+                           std::vector<int>::const_iterator last,
+                           int limit)
+    {
+        return std::find_if(first, last,
+                            std::bind2nd(std::greater_equal<int>(), limit)) != last;
     }
 
     template<typename R>
@@ -50,9 +149,25 @@ namespace ConsensusCore
                                                         std::string tpl)
         : recursor_(quiverConfig.MovesAvailable, quiverConfig.Banding),
           quiverConfig_(quiverConfig),
-          fwdTemplate_(tpl),
-          revTemplate_(ReverseComplement(tpl)),
-          scorerForRead_()
+          fwdTemplate_(new std::string(tpl)),
+          revTemplate_(new std::string(ReverseComplement(tpl))),
+          readIds_(),
+          strands_(),
+          templateStarts_(),
+          templateEnds_(),
+          scorers_(),
+          readBaseBounds_(),
+          active_(),
+          readScores_(),
+          coverage_(),
+          scoreCaches_(),
+          heldBytes_(),
+          usage_(0),
+          rankedSlots_(),
+          maxReadSpan_(0),
+          numReadsAdded_(0),
+          peakMemoryUsage_(0),
+          counters_()
     {
         DEBUG_ONLY(CheckInvariants());
     }
@@ -60,10 +175,9 @@ namespace ConsensusCore
     template<typename R>
     MultiReadMutationScorer<R>::~MultiReadMutationScorer()
     {
-        foreach (const item_t& kv, scorerForRead_)
+        foreach (ScorerType* scorer, scorers_)
         {
-            delete kv.first;
-            delete kv.second;
+            delete scorer;
         }
     }
 
@@ -71,21 +185,21 @@ namespace ConsensusCore
     int
     MultiReadMutationScorer<R>::TemplateLength() const
     {
-        return fwdTemplate_.length();
+        return fwdTemplate_->length();
     }
 
     template<typename R>
     int
     MultiReadMutationScorer<R>::NumReads() const
     {
-        return scorerForRead_.size();
+        return scorers_.size();
     }
 
     template<typename R>
     std::string
     MultiReadMutationScorer<R>::Template(StrandEnum strand) const
     {
-        return (strand == FORWARD_STRAND ? fwdTemplate_ : revTemplate_);
+        return (strand == FORWARD_STRAND ? *fwdTemplate_ : *revTemplate_);
     }
 
     template<typename R>
@@ -93,15 +207,24 @@ namespace ConsensusCore
     MultiReadMutationScorer<R>::Template(StrandEnum strand,
                                          int templateStart,
                                          int templateEnd) const
+    {
+        return TemplateRef(strand, templateStart, templateEnd).ToString();
+    }
+
+    template<typename R>
+    TemplateView
+    MultiReadMutationScorer<R>::TemplateRef(StrandEnum strand,
+                                            int templateStart,
+                                            int templateEnd) const
     {
         int len = templateEnd - templateStart;
         if (strand == FORWARD_STRAND)
         {
-            return fwdTemplate_.substr(templateStart, len);
+            return TemplateView(fwdTemplate_, templateStart, len);
         }
         else
         {
-            return revTemplate_.substr(TemplateLength() - templateEnd, len);
+            return TemplateView(revTemplate_, TemplateLength() - templateEnd, len);
         }
     }
 
@@ -110,91 +233,516 @@ namespace ConsensusCore
     MultiReadMutationScorer<R>::ApplyMutations(const std::vector<Mutation*>& mutations)
     {
         DEBUG_ONLY(CheckInvariants());
-        std::vector<int> mtp = TargetToQueryPositions(mutations, fwdTemplate_);
-        fwdTemplate_ = ConsensusCore::ApplyMutations(mutations, fwdTemplate_);
-        revTemplate_ = ReverseComplement(fwdTemplate_);
+        std::vector<int> mtp = TargetToQueryPositions(mutations, *fwdTemplate_);
+        std::string newTpl = ConsensusCore::ApplyMutations(mutations, *fwdTemplate_);
+        fwdTemplate_.reset(new std::string(newTpl));
+        revTemplate_.reset(new std::string(ReverseComplement(newTpl)));
 
-        foreach (const item_t& kv, scorerForRead_)
+        // Only the reads whose spans a mutation touches see a new
+        // template; the rest keep their matrices and cached scores.
+        int numReads = NumReads();
+        std::vector<TemplateView> newTemplates;
+        std::vector<bool> touched(numReads, false);
+        for (int slot = 0; slot < numReads; slot++)
         {
-            int newTemplateStart = mtp[kv.first->TemplateStart];
-            int newTemplateEnd   = mtp[kv.first->TemplateEnd];
-            kv.second->Template(Template(kv.first->Strand,
-                                         newTemplateStart,
-                                         newTemplateEnd));
-            kv.first->TemplateStart = newTemplateStart;
-            kv.first->TemplateEnd   = newTemplateEnd;
+            foreach (const Mutation* m, mutations)
+            {
+                if (m->Start() <= templateEnds_[slot] && m->End() >= templateStarts_[slot])
+                {
+                    touched[slot] = true;
+                }
+            }
+            if (touched[slot])
+            {
+                scoreCaches_[slot].clear();
+            }
+            templateStarts_[slot] = mtp[templateStarts_[slot]];
+            templateEnds_[slot]   = mtp[templateEnds_[slot]];
+            newTemplates.push_back(TemplateRef(strands_[slot],
+                                               templateStarts_[slot],
+                                               templateEnds_[slot]));
         }
+        rankedSlots_.clear();
+
+        std::vector<int> refills;
+        for (int slot = 0; slot < numReads; slot++)
+        {
+            if (touched[slot])
+            {
+                scorers_[slot]->Template(newTemplates[slot], false);
+                Account(slot);
+                // Inactive reads are not filled.
+                if (active_[slot] && !quiverConfig_.LazyFill)
+                {
+                    refills.push_back(slot);
+                }
+            }
+            else
+            {
+                scorers_[slot]->RebindTemplate(newTemplates[slot]);
+            }
+        }
+
+        // Refill each touched read against its new template.
+        FillRanked(refills);
+
+        // The remapping is monotone, so the reads stay in order, but
+        // their spans may have changed.
+        coverage_.clear();
+        SortReads();
+        EnforceMemoryBudget();
         DEBUG_ONLY(CheckInvariants());
     }
 
     template<typename R>
-    void MultiReadMutationScorer<R>::AddRead(const QvSequenceFeatures& features,
-                                             StrandEnum strand)
+    int MultiReadMutationScorer<R>::AddRead(const QvSequenceFeatures& features,
+                                            StrandEnum strand)
     {
-        AddRead(features, strand, 0, TemplateLength());
+        return AddRead(features, strand, 0, TemplateLength());
     }
 
     template<typename R>
-    void MultiReadMutationScorer<R>::AddRead(const QvSequenceFeatures & features,
-                                             StrandEnum strand,
-                                             int templateStart,
-                                             int templateEnd)
+    int MultiReadMutationScorer<R>::AddRead(const QvSequenceFeatures & features,
+                                            StrandEnum strand,
+                                            int templateStart,
+                                            int templateEnd)
     {
-        DEBUG_ONLY(CheckInvariants());
-        MappedRead* mr = new MappedRead(features, strand, templateStart, templateEnd);
-        EvaluatorType ev(features, Template(strand, templateStart, templateEnd), quiverConfig_.QvParams);
-        scorerForRead_[mr] = new MutationScorer<R>(ev, recursor_);
-        DEBUG_ONLY(CheckInvariants());
+        return AddRead(MappedRead(features, strand, templateStart, templateEnd));
     }
 
     template<typename R>
-    void MultiReadMutationScorer<R>::AddRead(const MappedRead& mr)
+    int MultiReadMutationScorer<R>::AddRead(const MappedRead& mr)
     {
         DEBUG_ONLY(CheckInvariants());
         EvaluatorType ev(mr.Features,
-                         Template(mr.Strand, mr.TemplateStart, mr.TemplateEnd),
+                         TemplateRef(mr.Strand, mr.TemplateStart, mr.TemplateEnd),
                          quiverConfig_.QvParams);
-        scorerForRead_[new MappedRead(mr)] = new MutationScorer<R>(ev, recursor_);
+        ScorerType* scorer = new MutationScorer<R>(ev, recursor_, quiverConfig_.LazyFill);
+        float readScore = 0;
+        if (quiverConfig_.MaximumCoverage > 0 || quiverConfig_.MemoryBudget > 0)
+        {
+            readScore = scorer->Score() / max(1, ev.ReadLength());
+        }
+        if (quiverConfig_.MemoryBudget > 0)
+        {
+            scorer->Release();
+        }
+
+        // The new read has the largest ID, so it goes after all the
+        // reads starting at or before it.
+        int readId = numReadsAdded_++;
+        int slot = std::upper_bound(templateStarts_.begin(), templateStarts_.end(),
+                                    mr.TemplateStart) - templateStarts_.begin();
+        readIds_.insert(readIds_.begin() + slot, readId);
+        strands_.insert(strands_.begin() + slot, mr.Strand);
+        templateStarts_.insert(templateStarts_.begin() + slot, mr.TemplateStart);
+        templateEnds_.insert(templateEnds_.begin() + slot, mr.TemplateEnd);
+        scorers_.insert(scorers_.begin() + slot, scorer);
+        readBaseBounds_.insert(readBaseBounds_.begin() + slot, ev.ReadBaseScoreUpperBounds());
+        active_.insert(active_.begin() + slot, true);
+        readScores_.insert(readScores_.begin() + slot, readScore);
+        scoreCaches_.insert(scoreCaches_.begin() + slot, ScoreCache());
+        heldBytes_.insert(heldBytes_.begin() + slot, 0);
+        rankedSlots_.clear();
+        Account(slot);
+        maxReadSpan_ = max(maxReadSpan_, mr.TemplateEnd - mr.TemplateStart);
+        AdmitRead(slot);
+        if (active_[slot] && !quiverConfig_.LazyFill && !scorer->IsFilled())
+        {
+            FillRanked(std::vector<int>(1, slot));
+        }
+        EnforceMemoryBudget();
+        DEBUG_ONLY(CheckInvariants());
+        return readId;
+    }
+
+    template<typename R>
+    void MultiReadMutationScorer<R>::AddReads(const std::vector<MappedRead>& mappedReads)
+    {
+        DEBUG_ONLY(CheckInvariants());
+        int numReads = mappedReads.size();
+        std::vector<EvaluatorType> evaluators;
+        evaluators.reserve(numReads);
+        foreach (const MappedRead& mr, mappedReads)
+        {
+            evaluators.push_back(
+                EvaluatorType(mr.Features,
+                              TemplateRef(mr.Strand, mr.TemplateStart, mr.TemplateEnd),
+                              quiverConfig_.QvParams));
+        }
+
+        // Constructing a scorer fills it (unless LazyFill is set); the
+        // reads are independent, so they are constructed in parallel.
+        // With a coverage limit or memory budget, each read's alignment
+        // score is needed to rank it; with a budget, the matrices are
+        // released as soon as they are scored, and the reads that fit
+        // refilled below.
+        std::vector<ScorerType*> scorers(numReads);
+        std::vector<float> readScores(numReads, 0.0f);
+        bool rankReads = (quiverConfig_.MaximumCoverage > 0 || quiverConfig_.MemoryBudget > 0);
+        bool releaseRanked = (quiverConfig_.MemoryBudget > 0);
+        #pragma omp parallel for schedule(dynamic) num_threads(NumThreads())
+        for (int i = 0; i < numReads; i++)
+        {
+            scorers[i] = new MutationScorer<R>(evaluators[i], recursor_,
+                                               quiverConfig_.LazyFill);
+            if (rankReads)
+            {
+                readScores[i] = scorers[i]->Score() / max(1, evaluators[i].ReadLength());
+            }
+            if (releaseRanked)
+            {
+                scorers[i]->Release();
+            }
+        }
+
+        for (int i = 0; i < numReads; i++)
+        {
+            const MappedRead& mr = mappedReads[i];
+            readIds_.push_back(numReadsAdded_++);
+            strands_.push_back(mr.Strand);
+            templateStarts_.push_back(mr.TemplateStart);
+            templateEnds_.push_back(mr.TemplateEnd);
+            scorers_.push_back(scorers[i]);
+            readBaseBounds_.push_back(evaluators[i].ReadBaseScoreUpperBounds());
+            active_.push_back(true);
+            readScores_.push_back(readScores[i]);
+            scoreCaches_.push_back(ScoreCache());
+            heldBytes_.push_back(0);
+            Account(NumReads() - 1);
+        }
+        SortReads();
+        SelectReads();
+        if (!quiverConfig_.LazyFill)
+        {
+            std::vector<int> unfilled;
+            for (int slot = 0; slot < NumReads(); slot++)
+            {
+                if (active_[slot] && !scorers_[slot]->IsFilled() &&
+                    readIds_[slot] >= numReadsAdded_ - numReads)
+                {
+                    unfilled.push_back(slot);
+                }
+            }
+            FillRanked(unfilled);
+        }
+        EnforceMemoryBudget();
+        DEBUG_ONLY(CheckInvariants());
+    }
+
+    template<typename R>
+    void MultiReadMutationScorer<R>::RemoveRead(int readId)
+    {
+        DEBUG_ONLY(CheckInvariants());
+        int slot = std::find(readIds_.begin(), readIds_.end(), readId) - readIds_.begin();
+        if (slot == NumReads())
+        {
+            throw InvalidInputError("No such read");
+        }
+        RemoveSlot(slot);
+        SortReads();
+        SelectReads();
+        EnforceMemoryBudget();
+        DEBUG_ONLY(CheckInvariants());
+    }
+
+    template<typename R>
+    void MultiReadMutationScorer<R>::RemoveSlot(int slot)
+    {
+        delete scorers_[slot];
+        usage_ -= heldBytes_[slot];
+        coverage_.clear();
+        rankedSlots_.clear();
+        readIds_.erase(readIds_.begin() + slot);
+        strands_.erase(strands_.begin() + slot);
+        templateStarts_.erase(templateStarts_.begin() + slot);
+        templateEnds_.erase(templateEnds_.begin() + slot);
+        scorers_.erase(scorers_.begin() + slot);
+        readBaseBounds_.erase(readBaseBounds_.begin() + slot);
+        active_.erase(active_.begin() + slot);
+        readScores_.erase(readScores_.begin() + slot);
+        scoreCaches_.erase(scoreCaches_.begin() + slot);
+        heldBytes_.erase(heldBytes_.begin() + slot);
+    }
+
+    template<typename R>
+    void MultiReadMutationScorer<R>::ExtendTemplate(const std::string& leftBases,
+                                                    const std::string& rightBases)
+    {
+        DEBUG_ONLY(CheckInvariants());
+        ReplaceTemplate(leftBases + *fwdTemplate_ + rightBases, leftBases.length());
+        DEBUG_ONLY(CheckInvariants());
+    }
+
+    template<typename R>
+    std::vector<int> MultiReadMutationScorer<R>::TrimTemplate(int leftLength, int rightLength)
+    {
+        DEBUG_ONLY(CheckInvariants());
+        if (leftLength < 0 || rightLength < 0 || leftLength + rightLength > TemplateLength())
+        {
+            throw InvalidInputError("Cannot trim template by more than its length");
+        }
+        int newEnd = TemplateLength() - rightLength;
+        std::vector<int> removed;
+        for (int slot = NumReads() - 1; slot >= 0; slot--)
+        {
+            if (templateStarts_[slot] < leftLength || templateEnds_[slot] > newEnd)
+            {
+                removed.push_back(readIds_[slot]);
+                RemoveSlot(slot);
+            }
+        }
+        std::sort(removed.begin(), removed.end());
+        ReplaceTemplate(fwdTemplate_->substr(leftLength, newEnd - leftLength), -leftLength);
+        SortReads();
+        SelectReads();
+        EnforceMemoryBudget();
         DEBUG_ONLY(CheckInvariants());
+        return removed;
+    }
+
+    // Switch to a new template in which the template span of each read
+    // is unchanged, but shifted by shift.
+    template<typename R>
+    void MultiReadMutationScorer<R>::ReplaceTemplate(const std::string& tpl, int shift)
+    {
+        fwdTemplate_.reset(new std::string(tpl));
+        revTemplate_.reset(new std::string(ReverseComplement(tpl)));
+        coverage_.clear();
+        for (int slot = 0; slot < NumReads(); slot++)
+        {
+            templateStarts_[slot] += shift;
+            templateEnds_[slot]   += shift;
+            scorers_[slot]->RebindTemplate(TemplateRef(strands_[slot],
+                                                       templateStarts_[slot],
+                                                       templateEnds_[slot]));
+        }
     }
 
-    static Mutation orientedMutation(const MappedRead* mr,
-                                     const Mutation& mut)
+    // A read scores a mutation if it is active and its template span
+    // contains the span of the mutation; insertions may fall at either
+    // end of the read.
+    template<typename R>
+    bool MultiReadMutationScorer<R>::ReadScoresMutation(int slot, const Mutation& m) const
+    {
+        return (active_[slot] &&
+                templateStarts_[slot] <= m.Start() &&
+                templateEnds_[slot]   >= m.End());
+    }
+
+    template<typename R>
+    Mutation MultiReadMutationScorer<R>::OrientedMutation(int slot, const Mutation& mut) const
     {
-        if (mr->Strand == FORWARD_STRAND)
+        if (strands_[slot] == FORWARD_STRAND)
         {
             return Mutation(mut.Type(),
-                            mut.Position() - mr->TemplateStart,
-                            mut.Base());
+                            mut.Start() - templateStarts_[slot],
+                            mut.End() - templateStarts_[slot],
+                            mut.NewBases());
         }
         else
         {
-            // This is tricky business.  Insertions require an
-            // adjustment to maintain the pre-base semantic.
-            int pos = mr->TemplateEnd- 1 - mut.Position() \
-                    + (mut.IsInsertion() ? 1 : 0);
+            // This is tricky business.  The span [Start, End) maps to
+            // [TemplateEnd - End, TemplateEnd - Start) on the reverse
+            // strand, which also maintains the pre-base semantic for
+            // insertions.
             return Mutation(mut.Type(),
-                            pos,
-                            ComplementaryBase(mut.Base()));
+                            templateEnds_[slot] - mut.End(),
+                            templateEnds_[slot] - mut.Start(),
+                            ReverseComplement(mut.NewBases()));
         }
     }
 
+    // The change in the score of a read caused by a mutation it scores.
+    // The cache is keyed by the oriented mutation, which does not change
+    // when edits elsewhere shift the read on the template.  Callers
+    // account for the cache.
+    template<typename R>
+    float MultiReadMutationScorer<R>::ReadScoreDelta(int slot, const Mutation& m) const
+    {
+        Mutation orientedMut = OrientedMutation(slot, m);
+        if (!quiverConfig_.CacheScores)
+        {
+            FillRead(slot, m.Start(), m.End());
+            return (scorers_[slot]->ScoreMutation(orientedMut) -
+                    scorers_[slot]->Score());
+        }
+        ScoreCache& cache = scoreCaches_[slot];
+        typename ScoreCache::const_iterator it = cache.find(orientedMut);
+        if (it != cache.end())
+        {
+            return it->second;
+        }
+        FillRead(slot, m.Start(), m.End());
+        float delta = (scorers_[slot]->ScoreMutation(orientedMut) -
+                       scorers_[slot]->Score());
+        cache.insert(std::make_pair(orientedMut, delta));
+        return delta;
+    }
+
     template<typename R>
     float MultiReadMutationScorer<R>::Score(const Mutation& m) const
     {
         float sum = 0;
-        foreach (const item_t& kv, scorerForRead_)
+        std::pair<int, int> slots = ReadsSpanning(m);
+        for (int slot = slots.first; slot < slots.second; slot++)
         {
-            if (readScoresPosition(kv.first, m.Position()))
+            if (ReadScoresMutation(slot, m))
             {
-                Mutation orientedMut = orientedMutation(kv.first, m);
-                sum += (kv.second->ScoreMutation(orientedMut) -
-                        kv.second->Score());
+                sum += ReadScoreDelta(slot, m);
+                Account(slot);
             }
         }
+        ReleaseOverBudget(m.Start(), m.End());
         return sum;
     }
 
+    // Orders mutations (by index) by start.
+    class MutationStartLessThan
+    {
+    public:
+        explicit MutationStartLessThan(const std::vector<Mutation>& mutations)
+            : mutations_(mutations)
+        {}
+
+        bool operator()(int m1, int m2) const
+        {
+            return mutations_[m1].Start() < mutations_[m2].Start();
+        }
+
+    private:
+        const std::vector<Mutation>& mutations_;
+    };
+
+    template<typename R>
+    std::vector<float>
+    MultiReadMutationScorer<R>::Score(const std::vector<Mutation>& mutations) const
+    {
+        int numMutations = mutations.size();
+        std::vector<int> byStart(numMutations);
+        for (int i = 0; i < numMutations; i++)
+        {
+            byStart[i] = i;
+        }
+        std::stable_sort(byStart.begin(), byStart.end(), MutationStartLessThan(mutations));
+        std::vector<int> starts(numMutations);
+        for (int i = 0; i < numMutations; i++)
+        {
+            starts[i] = mutations[byStart[i]].Start();
+        }
+
+        // The reads are scored in chunks of consecutive slots.  Room is
+        // made within the memory budget for the reads of a chunk that
+        // need filling, which are then filled, and scored, concurrently:
+        // each read touches only its own scorer and cache.  The deltas
+        // of each read are kept, by mutation index, to be totalled
+        // afterwards.
+        int numReads = NumReads();
+        long budget = quiverConfig_.MemoryBudget;
+        std::vector<int> firstMutation(numReads);
+        std::vector<std::vector<std::pair<int, float> > > deltas(numReads);
+        for (int first = 0; first < numReads; )
+        {
+            std::vector<int> chunk;
+            std::vector<ScorerType*> unfilled;
+            long need = 0;
+            int last = first;
+            for (; last < numReads && (int)chunk.size() < NumThreads(); last++)
+            {
+                int i = std::lower_bound(starts.begin(), starts.end(),
+                                         templateStarts_[last]) - starts.begin();
+                firstMutation[last] = i;
+                bool scoresAny = false;
+                for (; !scoresAny && i < numMutations && starts[i] <= templateEnds_[last]; i++)
+                {
+                    scoresAny = ReadScoresMutation(last, mutations[byStart[i]]);
+                }
+                if (!scoresAny) continue;
+                long bytes = (scorers_[last]->IsFilled() ? 0 : scorers_[last]->FilledBytes());
+                if (budget > 0 && !chunk.empty() && need + bytes > budget) break;
+                chunk.push_back(last);
+                need += bytes;
+                if (!scorers_[last]->IsFilled()) unfilled.push_back(scorers_[last]);
+            }
+
+            ReleaseForRoom(need, 0, 0, first, last);
+            FillScorers(unfilled);
+            foreach (int slot, chunk)
+            {
+                Account(slot);
+            }
+
+            #pragma omp parallel for schedule(dynamic) num_threads(NumThreads())
+            for (int c = 0; c < static_cast<int>(chunk.size()); c++)
+            {
+                int slot = chunk[c];
+                for (int i = firstMutation[slot];
+                     i < numMutations && starts[i] <= templateEnds_[slot]; i++)
+                {
+                    const Mutation& m = mutations[byStart[i]];
+                    if (ReadScoresMutation(slot, m))
+                    {
+                        deltas[slot].push_back(std::make_pair(byStart[i],
+                                                              ReadScoreDelta(slot, m)));
+                    }
+                }
+            }
+            foreach (int slot, chunk)
+            {
+                Account(slot);
+            }
+            first = last;
+        }
+
+        ReleaseOverBudget(0, 0);
+
+        // Total in slot order, as Score does.
+        std::vector<float> scores(numMutations, 0.0f);
+        for (int slot = 0; slot < numReads; slot++)
+        {
+            for (int i = 0; i < static_cast<int>(deltas[slot].size()); i++)
+            {
+                scores[deltas[slot][i].first] += deltas[slot][i].second;
+            }
+        }
+        return scores;
+    }
+
+    template<typename R>
+    std::vector<int> MultiReadMutationScorer<R>::ConsensusQVs() const
+    {
+        int tplLength = TemplateLength();
+        std::vector<Mutation> mutations =
+            UniqueSingleBaseMutations(*fwdTemplate_, 0, tplLength);
+        std::vector<float> scores = Score(mutations);
+
+        // Sum the likelihood ratios at each position in log space, as
+        // favorable mutations can have large scores.
+        std::vector<double> maxScores(tplLength, -DBL_MAX);
+        for (int i = 0; i < static_cast<int>(mutations.size()); i++)
+        {
+            int pos = min(mutations[i].Start(), tplLength - 1);
+            maxScores[pos] = max(maxScores[pos], static_cast<double>(scores[i]));
+        }
+        std::vector<double> sums(tplLength, 0.0);
+        for (int i = 0; i < static_cast<int>(mutations.size()); i++)
+        {
+            int pos = min(mutations[i].Start(), tplLength - 1);
+            sums[pos] += exp(scores[i] - maxScores[pos]);
+        }
+
+        // With the log of the summed ratios L, the probability of error
+        // is e^L / (1 + e^L), so QV = 10 log10(1 + e^-L).
+        std::vector<int> qvs(tplLength);
+        for (int pos = 0; pos < tplLength; pos++)
+        {
+            double logRatio = maxScores[pos] + log(sums[pos]);
+            double qv = 10 * log10(1 + exp(-logRatio));
+            qvs[pos] = static_cast<int>(floor(min(qv, double(MAX_CONSENSUS_QV)) + 0.5));
+        }
+        return qvs;
+    }
+
     template<typename R>
     float MultiReadMutationScorer<R>::Score(MutationType mutationType,
                                             int position, char base) const
@@ -206,108 +754,680 @@ namespace ConsensusCore
     template<typename R>
     float MultiReadMutationScorer<R>::FastScore(const Mutation& m) const
     {
-        float sum = 0;
-        foreach (const item_t& kv, scorerForRead_)
+        float cutoff = min(quiverConfig_.FastScoreThreshold, 0.0f);
+        float score = BoundedScore(m, cutoff);
+        ReleaseOverBudget(m.Start(), m.End());
+        return score;
+    }
+
+    template<typename R>
+    std::vector<float> MultiReadMutationScorer<R>::Scores(const Mutation& m) const
+    {
+        std::vector<float> scoreByRead(numReadsAdded_, -FLT_MAX);
+        std::pair<int, int> slots = ReadsSpanning(m);
+        for (int slot = slots.first; slot < slots.second; slot++)
+        {
+            if (ReadScoresMutation(slot, m))
+            {
+                scoreByRead[readIds_[slot]] = ReadScoreDelta(slot, m);
+                Account(slot);
+            }
+        }
+        ReleaseOverBudget(m.Start(), m.End());
+        return scoreByRead;
+    }
+
+    template<typename R>
+    bool MultiReadMutationScorer<R>::IsFavorable(const Mutation& m) const
+    {
+        return (Score(m) > 0);
+    }
+
+    template<typename R>
+    bool MultiReadMutationScorer<R>::FastIsFavorable(const Mutation& m) const
+    {
+        bool favorable = (BoundedScore(m, 0.0f) > 0);
+        ReleaseOverBudget(m.Start(), m.End());
+        return favorable;
+    }
+
+    template<typename R>
+    float MultiReadMutationScorer<R>::BoundedScore(const Mutation& m, float cutoff) const
+    {
+        // Each read's score after the mutation is bounded by the best way
+        // through the few template columns the mutation changes (see
+        // MutationScorer::ScoreMutationUpperBound).  The total score is
+        // at most the deltas scored so far plus the bounds of the reads
+        // still to score, and scoring stops once that is below the
+        // cutoff.  Reads that can't be bounded are scored first.
+        std::vector<int> spanning;
+        std::vector<float> bounds;
+        std::vector<int> order;
+        double remainingBound = 0;
+        std::pair<int, int> slots = ReadsSpanning(m);
+        for (int slot = slots.first; slot < slots.second; slot++)
+        {
+            if (ReadScoresMutation(slot, m))
+            {
+                FillRead(slot, m.Start(), m.End());
+                float bound = FLT_MAX;
+                if (!readBaseBounds_[slot].empty())
+                {
+                    bound = scorers_[slot]->ScoreMutationUpperBound(OrientedMutation(slot, m),
+                                                                    readBaseBounds_[slot]);
+                }
+                if (bound == FLT_MAX)
+                {
+                    order.push_back(spanning.size());
+                }
+                else
+                {
+                    bound -= scorers_[slot]->Score();
+                    remainingBound += bound;
+                }
+                spanning.push_back(slot);
+                bounds.push_back(bound);
+            }
+        }
+        int numSpanning = spanning.size();
+        int numUnbounded = order.size();
+        for (int r = 0; r < numSpanning; r++)
+        {
+            if (bounds[r] != FLT_MAX) order.push_back(r);
+        }
+        counters_.Mutations++;
+        counters_.ReadsSpanning += numSpanning;
+
+        std::vector<float> deltas(numSpanning);
+        double sum = 0;
+        for (int n = 0; n < numSpanning; n++)
         {
-            if (readScoresPosition(kv.first, m.Position()))
+            int r = order[n];
+            if (n >= numUnbounded)
             {
-                Mutation orientedMut = orientedMutation(kv.first, m);
-                sum += (kv.second->ScoreMutation(orientedMut) -
-                        kv.second->Score());
-                // Hack alert: I need to replace this cut-out with
-                // something more justifiable.  I am just checking it in
-                // now to play with.
-                if (sum < quiverConfig_.FastScoreThreshold)
+                double bound = sum + remainingBound;
+                if (bound < cutoff - BOUND_TOLERANCE)
                 {
-                    return sum;
+                    return bound;
                 }
+                remainingBound -= bounds[r];
+            }
+            deltas[r] = ReadScoreDelta(spanning[r], m);
+            Account(spanning[r]);
+            counters_.ReadsEvaluated++;
+            sum += deltas[r];
+        }
+
+        // Every read was scored; total them in the same order as Score.
+        float total = 0;
+        foreach (float delta, deltas)
+        {
+            total += delta;
+        }
+        return total;
+    }
+
+    template<typename R>
+    const FastScoreCounters& MultiReadMutationScorer<R>::Counters() const
+    {
+        return counters_;
+    }
+
+    template<typename R>
+    void MultiReadMutationScorer<R>::ResetCounters()
+    {
+        counters_ = FastScoreCounters();
+    }
+
+    template<typename R>
+    int MultiReadMutationScorer<R>::NumCachedScores() const
+    {
+        int n = 0;
+        foreach (const ScoreCache& cache, scoreCaches_)
+        {
+            n += cache.size();
+        }
+        return n;
+    }
+
+    template<typename R>
+    void MultiReadMutationScorer<R>::Prefetch()
+    {
+        Prefetch(0, TemplateLength());
+    }
+
+    template<typename R>
+    void MultiReadMutationScorer<R>::Prefetch(int templateStart, int templateEnd)
+    {
+        int first = std::lower_bound(templateStarts_.begin(), templateStarts_.end(),
+                                     templateStart - maxReadSpan_) - templateStarts_.begin();
+        int last  = std::lower_bound(templateStarts_.begin(), templateStarts_.end(),
+                                     templateEnd) - templateStarts_.begin();
+        std::vector<int> unfilled;
+        for (int slot = first; slot < last; slot++)
+        {
+            if (active_[slot] && templateEnds_[slot] > templateStart &&
+                !scorers_[slot]->IsFilled())
+            {
+                unfilled.push_back(slot);
+            }
+        }
+        FillRanked(unfilled);
+        EnforceMemoryBudget();
+    }
+
+    template<typename R>
+    void MultiReadMutationScorer<R>::Release()
+    {
+        for (int slot = 0; slot < NumReads(); slot++)
+        {
+            scorers_[slot]->Release();
+            Account(slot);
+        }
+    }
+
+    template<typename R>
+    int MultiReadMutationScorer<R>::NumFilledReads() const
+    {
+        int n = 0;
+        foreach (const ScorerType* scorer, scorers_)
+        {
+            if (scorer->IsFilled()) n++;
+        }
+        return n;
+    }
+
+    template<typename R>
+    float MultiReadMutationScorer<R>::BaselineScore() const
+    {
+        float sum = 0;
+        for (int slot = 0; slot < NumReads(); slot++)
+        {
+            if (active_[slot])
+            {
+                FillRead(slot, templateStarts_[slot], templateEnds_[slot]);
+                sum += scorers_[slot]->Score();
             }
         }
         return sum;
     }
 
     template<typename R>
-    std::vector<float> MultiReadMutationScorer<R>::Scores(const Mutation& m) const
+    std::pair<int, int>
+    MultiReadMutationScorer<R>::ReadsSpanning(const Mutation& m) const
     {
-        std::vector<float> scoreByRead;
-        foreach (const item_t& kv, scorerForRead_)
+        // A read spanning m starts at or before m.Start(), and no
+        // earlier than maxReadSpan_ before m.End().
+        int first = std::lower_bound(templateStarts_.begin(), templateStarts_.end(),
+                                     m.End() - maxReadSpan_) - templateStarts_.begin();
+        int last  = std::upper_bound(templateStarts_.begin() + first, templateStarts_.end(),
+                                     m.Start()) - templateStarts_.begin();
+        return std::make_pair(first, last);
+    }
+
+    template<typename R>
+    void MultiReadMutationScorer<R>::SortReads()
+    {
+        std::vector<int> order(NumReads());
+        for (int slot = 0; slot < NumReads(); slot++)
+        {
+            order[slot] = slot;
+        }
+        std::sort(order.begin(), order.end(), ReadSlotLessThan(templateStarts_, readIds_));
+        permute(readIds_, order);
+        permute(strands_, order);
+        permute(templateStarts_, order);
+        permute(templateEnds_, order);
+        permute(scorers_, order);
+        permute(readBaseBounds_, order);
+        permute(active_, order);
+        permute(readScores_, order);
+        permute(heldBytes_, order);
+        permute(scoreCaches_, order);
+        rankedSlots_.clear();
+
+        maxReadSpan_ = 0;
+        for (int slot = 0; slot < NumReads(); slot++)
+        {
+            maxReadSpan_ = max(maxReadSpan_, templateEnds_[slot] - templateStarts_[slot]);
+        }
+    }
+
+    template<typename R>
+    void MultiReadMutationScorer<R>::SelectReads()
+    {
+        int maxCoverage = quiverConfig_.MaximumCoverage;
+        if (maxCoverage <= 0) return;
+
+        std::vector<int> coverage(TemplateLength(), 0);
+        std::vector<int> admitted;
+        foreach (int slot, SlotsByRank())
         {
-            if (readScoresPosition(kv.first, m.Position()))
+            int start = templateStarts_[slot];
+            int end   = templateEnds_[slot];
+            bool admit = (start == end ||
+                          *std::max_element(coverage.begin() + start,
+                                            coverage.begin() + end) < maxCoverage);
+            if (admit)
             {
-                Mutation orientedMut = orientedMutation(kv.first, m);
-                scoreByRead.push_back(kv.second->ScoreMutation(orientedMut) -
-                                      kv.second->Score());
+                for (int pos = start; pos < end; pos++)
+                {
+                    coverage[pos]++;
+                }
+                if (!active_[slot])
+                {
+                    admitted.push_back(slot);
+                }
             }
             else
             {
-                scoreByRead.push_back(-FLT_MAX);
+                scorers_[slot]->Release();
+                Account(slot);
             }
+            active_[slot] = admit;
+        }
+        coverage_.swap(coverage);
+        if (!quiverConfig_.LazyFill)
+        {
+            FillRanked(admitted);
         }
-        return scoreByRead;
     }
 
     template<typename R>
-    bool MultiReadMutationScorer<R>::IsFavorable(const Mutation& m) const
+    void MultiReadMutationScorer<R>::CountCoverage()
     {
-        float sum = 0;
-        foreach (const item_t& kv, scorerForRead_)
+        coverage_.assign(TemplateLength(), 0);
+        for (int slot = 0; slot < NumReads(); slot++)
         {
-            if (readScoresPosition(kv.first, m.Position()))
+            if (active_[slot])
             {
-                Mutation orientedMut = orientedMutation(kv.first, m);
-                sum += (kv.second->ScoreMutation(orientedMut) -
-                        kv.second->Score());
+                for (int pos = templateStarts_[slot]; pos < templateEnds_[slot]; pos++)
+                {
+                    coverage_[pos]++;
+                }
             }
         }
-        return (sum > 0);
     }
 
+    // Admit the read in the given (newly added) slot if there is room
+    // for it, or if there would be once some of the active reads it
+    // overlaps and outranks are displaced, lowest ranked first.  Only
+    // the reads near the new one are visited.
     template<typename R>
-    bool MultiReadMutationScorer<R>::FastIsFavorable(const Mutation& m) const
+    void MultiReadMutationScorer<R>::AdmitRead(int slot)
     {
-        float sum = 0;
-        foreach (const item_t& kv, scorerForRead_)
+        int maxCoverage = quiverConfig_.MaximumCoverage;
+        if (maxCoverage <= 0) return;
+        active_[slot] = false;
+        if ((int)coverage_.size() != TemplateLength())
+        {
+            CountCoverage();
+        }
+
+        int start = templateStarts_[slot];
+        int end   = templateEnds_[slot];
+        ReadRankGreaterThan rankGreater(templateStarts_, templateEnds_, readScores_, readIds_);
+        int first = std::lower_bound(templateStarts_.begin(), templateStarts_.end(),
+                                     start - maxReadSpan_) - templateStarts_.begin();
+        int last  = std::lower_bound(templateStarts_.begin(), templateStarts_.end(),
+                                     end) - templateStarts_.begin();
+        std::vector<int> candidates;
+        for (int other = first; other < last; other++)
         {
-            if (readScoresPosition(kv.first, m.Position()))
+            if (active_[other] && templateEnds_[other] > start && rankGreater(slot, other))
             {
-                Mutation orientedMut = orientedMutation(kv.first, m);
-                sum += (kv.second->ScoreMutation(orientedMut) -
-                        kv.second->Score());
-                // Hack alert: I need to replace this cut-out with
-                // something more justifiable.  I am just checking it in
-                // now to play with.
-                if (sum < quiverConfig_.FastScoreThreshold)
+                candidates.push_back(other);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), rankGreater);
+
+        // Displace candidates, worst first, while some position of the
+        // span is full; those only covering positions with room are
+        // passed over.
+        std::vector<int> spanCoverage(coverage_.begin() + start, coverage_.begin() + end);
+        std::vector<int> displaced;
+        for (int i = candidates.size() - 1;
+             i >= 0 && anyAtLimit(spanCoverage.begin(), spanCoverage.end(), maxCoverage);
+             i--)
+        {
+            int other = candidates[i];
+            int overlapStart = max(start, templateStarts_[other]) - start;
+            int overlapEnd   = min(end, templateEnds_[other]) - start;
+            if (anyAtLimit(spanCoverage.begin() + overlapStart,
+                           spanCoverage.begin() + overlapEnd, maxCoverage))
+            {
+                for (int pos = overlapStart; pos < overlapEnd; pos++)
                 {
-                    return false;
+                    spanCoverage[pos]--;
                 }
+                displaced.push_back(other);
             }
         }
-        return (sum > 0);
+
+        if (anyAtLimit(spanCoverage.begin(), spanCoverage.end(), maxCoverage))
+        {
+            displaced.assign(1, slot);
+        }
+        else
+        {
+            active_[slot] = true;
+            for (int pos = start; pos < end; pos++)
+            {
+                coverage_[pos]++;
+            }
+            foreach (int other, displaced)
+            {
+                for (int pos = templateStarts_[other]; pos < templateEnds_[other]; pos++)
+                {
+                    coverage_[pos]--;
+                }
+                active_[other] = false;
+            }
+        }
+        foreach (int other, displaced)
+        {
+            scorers_[other]->Release();
+            Account(other);
+        }
     }
 
+    // Read slots, best first.  The order is kept until the reads or
+    // their spans change.
     template<typename R>
-    float MultiReadMutationScorer<R>::BaselineScore() const
+    const std::vector<int>& MultiReadMutationScorer<R>::SlotsByRank() const
     {
-        float sum = 0;
-        foreach (const item_t& kv, scorerForRead_)
+        if ((int)rankedSlots_.size() != NumReads())
         {
-            sum += kv.second->Score();
+            rankedSlots_.resize(NumReads());
+            for (int slot = 0; slot < NumReads(); slot++)
+            {
+                rankedSlots_[slot] = slot;
+            }
+            std::sort(rankedSlots_.begin(), rankedSlots_.end(),
+                      ReadRankGreaterThan(templateStarts_, templateEnds_, readScores_, readIds_));
+        }
+        return rankedSlots_;
+    }
+
+    // Fill a read on demand, first making room for it within the memory
+    // budget by releasing other reads, those overlapping [keepStart,
+    // keepEnd) last.
+    template<typename R>
+    void MultiReadMutationScorer<R>::FillRead(int slot, int keepStart, int keepEnd) const
+    {
+        if (scorers_[slot]->IsFilled()) return;
+        ReleaseForRoom(scorers_[slot]->FilledBytes(), keepStart, keepEnd, slot, slot + 1);
+        scorers_[slot]->Fill();
+        Account(slot);
+    }
+
+    // Fill reads, best ranked first, in parallel chunks.  With a memory
+    // budget, room is made for each read beforehand by shedding the
+    // reads ranked below it, lowest first---per OverBudgetPolicy---and
+    // a read is sized by its last fill.  Once no more room can be made,
+    // the remaining reads are left unfilled or, with DROP_READS, made
+    // inactive.
+    template<typename R>
+    void MultiReadMutationScorer<R>::FillRanked(const std::vector<int>& slots)
+    {
+        long budget = quiverConfig_.MemoryBudget;
+        if (budget <= 0)
+        {
+            std::vector<ScorerType*> scorers;
+            foreach (int slot, slots)
+            {
+                scorers.push_back(scorers_[slot]);
+            }
+            FillScorers(scorers);
+            foreach (int slot, slots)
+            {
+                Account(slot);
+            }
+            return;
+        }
+
+        ReadRankGreaterThan rankGreater(templateStarts_, templateEnds_, readScores_, readIds_);
+        std::vector<int> toFill(slots);
+        std::sort(toFill.begin(), toFill.end(), rankGreater);
+        const std::vector<int>& ranked = SlotsByRank();
+        int shed = NumReads() - 1;
+        int next = 0;
+        bool full = false;
+        while (next < (int)toFill.size() && !full)
+        {
+            std::vector<int> chunk;
+            std::vector<ScorerType*> scorers;
+            long chunkBytes = 0;
+            for (; next < (int)toFill.size() && (int)chunk.size() < NumThreads(); next++)
+            {
+                int slot = toFill[next];
+                if (!active_[slot]) continue;
+                long need = chunkBytes + scorers_[slot]->FilledBytes();
+                while (usage_ + need > budget && shed >= 0 && rankGreater(slot, ranked[shed]))
+                {
+                    int other = ranked[shed--];
+                    if (heldBytes_[other] > 0)
+                    {
+                        ShedSlot(other);
+                    }
+                }
+                full = (usage_ + need > budget);
+                if (full) break;
+                chunk.push_back(slot);
+                scorers.push_back(scorers_[slot]);
+                chunkBytes = need;
+            }
+
+            FillScorers(scorers);
+            foreach (int slot, chunk)
+            {
+                Account(slot);
+            }
+        }
+
+        // The rest do not fit.
+        for (; next < (int)toFill.size(); next++)
+        {
+            if (quiverConfig_.OverBudgetPolicy == DROP_READS && active_[toFill[next]])
+            {
+                active_[toFill[next]] = false;
+                coverage_.clear();
+            }
+        }
+    }
+
+    template<typename R>
+    void MultiReadMutationScorer<R>::ShedSlot(int slot)
+    {
+        if (quiverConfig_.OverBudgetPolicy == DROP_READS && active_[slot])
+        {
+            active_[slot] = false;
+            coverage_.clear();
+        }
+        ReleaseSlot(slot);
+    }
+
+    // An estimate of the bytes held by a read's score cache: each entry
+    // is a tree node holding the key and value, plus the node's links.
+    template<typename R>
+    long MultiReadMutationScorer<R>::CacheBytes(int slot) const
+    {
+        long entryBytes = sizeof(typename ScoreCache::value_type) + 4 * sizeof(void*);
+        return scoreCaches_[slot].size() * entryBytes;
+    }
+
+    // Bring the usage up to date with a read's matrices and cache.
+    template<typename R>
+    void MultiReadMutationScorer<R>::Account(int slot) const
+    {
+        long bytes = scorers_[slot]->AllocatedBytes() + CacheBytes(slot);
+        usage_ += bytes - heldBytes_[slot];
+        heldBytes_[slot] = bytes;
+        peakMemoryUsage_ = max(peakMemoryUsage_, usage_);
+    }
+
+    template<typename R>
+    void MultiReadMutationScorer<R>::ReleaseSlot(int slot) const
+    {
+        scorers_[slot]->Release();
+        ScoreCache().swap(scoreCaches_[slot]);
+        Account(slot);
+    }
+
+    template<typename R>
+    long MultiReadMutationScorer<R>::MemoryUsage() const
+    {
+        return usage_;
+    }
+
+    template<typename R>
+    long MultiReadMutationScorer<R>::PeakMemoryUsage() const
+    {
+        return peakMemoryUsage_;
+    }
+
+    template<typename R>
+    void MultiReadMutationScorer<R>::ResetPeakMemoryUsage()
+    {
+        peakMemoryUsage_ = usage_;
+    }
+
+    template<typename R>
+    void MultiReadMutationScorer<R>::EnforceMemoryBudget()
+    {
+        long budget = quiverConfig_.MemoryBudget;
+        if (budget <= 0 || usage_ <= budget) return;
+
+        if (quiverConfig_.OverBudgetPolicy == DROP_READS)
+        {
+            const std::vector<int>& ranked = SlotsByRank();
+            for (int i = NumReads() - 1; i >= 0 && usage_ > budget; i--)
+            {
+                int slot = ranked[i];
+                if (active_[slot] && scorers_[slot]->IsFilled())
+                {
+                    ShedSlot(slot);
+                }
+            }
+        }
+        ReleaseOverBudget(0, 0);
+    }
+
+    template<typename R>
+    void MultiReadMutationScorer<R>::ReleaseOverBudget(int keepStart, int keepEnd) const
+    {
+        ReleaseForRoom(0, keepStart, keepEnd, 0, 0);
+    }
+
+    // Release reads until needed more bytes fit within the budget.  The
+    // lowest ranked reads are released first, those overlapping
+    // [keepStart, keepEnd) last of all, and those in slots [pinFirst,
+    // pinLast) never.
+    template<typename R>
+    void MultiReadMutationScorer<R>::ReleaseForRoom(long needed,
+                                                   int keepStart, int keepEnd,
+                                                   int pinFirst, int pinLast) const
+    {
+        long budget = quiverConfig_.MemoryBudget;
+        if (budget <= 0 || usage_ + needed <= budget) return;
+
+        const std::vector<int>& ranked = SlotsByRank();
+        for (int pass = 0; pass < 2 && usage_ + needed > budget; pass++)
+        {
+            for (int i = NumReads() - 1; i >= 0 && usage_ + needed > budget; i--)
+            {
+                int slot = ranked[i];
+                bool keep = (templateStarts_[slot] <= keepEnd && templateEnds_[slot] >= keepStart);
+                bool pinned = (pinFirst <= slot && slot < pinLast);
+                if ((pass == 1 || !keep) && !pinned && heldBytes_[slot] > 0)
+                {
+                    ReleaseSlot(slot);
+                }
+            }
+        }
+    }
+
+    template<typename R>
+    bool MultiReadMutationScorer<R>::IsActive(int readId) const
+    {
+        int slot = std::find(readIds_.begin(), readIds_.end(), readId) - readIds_.begin();
+        return (slot < NumReads() && active_[slot]);
+    }
+
+    template<typename R>
+    int MultiReadMutationScorer<R>::NumActiveReads() const
+    {
+        return std::count(active_.begin(), active_.end(), true);
+    }
+
+    template<typename R>
+    int MultiReadMutationScorer<R>::NumThreads() const
+    {
+#ifdef _OPENMP
+        if (quiverConfig_.NumThreads <= 0)
+        {
+            return omp_get_max_threads();
+        }
+#endif  // _OPENMP
+        return max(1, quiverConfig_.NumThreads);
+    }
+
+    template<typename R>
+    void MultiReadMutationScorer<R>::FillScorers(const std::vector<ScorerType*>& scorers) const
+    {
+        // Each scorer owns its evaluator, recursor and matrices, so the
+        // fills are independent and the results do not depend on the
+        // number of threads.
+        #pragma omp parallel for schedule(dynamic) num_threads(NumThreads())
+        for (int i = 0; i < static_cast<int>(scorers.size()); i++)
+        {
+            scorers[i]->Fill();
         }
-        return sum;
     }
 
     template<typename R>
     void MultiReadMutationScorer<R>::CheckInvariants() const
     {
 #ifndef NDEBUG
-        assert(revTemplate_ == ReverseComplement(fwdTemplate_));
-        foreach (const item_t& kv, scorerForRead_)
-        {
-            assert((int)kv.second->Template().length() ==
-                   kv.first->TemplateEnd - kv.first->TemplateStart);
-            assert(kv.second->Template() == Template(kv.first->Strand,
-                                                     kv.first->TemplateStart,
-                                                     kv.first->TemplateEnd));
+        assert(*revTemplate_ == ReverseComplement(*fwdTemplate_));
+        int numReads = NumReads();
+        assert((int)readIds_.size() == numReads &&
+               (int)strands_.size() == numReads &&
+               (int)templateStarts_.size() == numReads &&
+               (int)templateEnds_.size() == numReads &&
+               (int)readBaseBounds_.size() == numReads &&
+               (int)active_.size() == numReads &&
+               (int)readScores_.size() == numReads &&
+               (int)scoreCaches_.size() == numReads &&
+               (int)heldBytes_.size() == numReads);
+        long usage = 0;
+        for (int slot = 0; slot < numReads; slot++)
+        {
+            assert(slot == 0 ||
+                   ReadSlotLessThan(templateStarts_, readIds_)(slot - 1, slot));
+            assert(templateEnds_[slot] - templateStarts_[slot] <= maxReadSpan_);
+            const ScorerType* scorer = scorers_[slot];
+            assert(heldBytes_[slot] == scorer->AllocatedBytes() + CacheBytes(slot));
+            usage += heldBytes_[slot];
+            assert(scorer->TemplateLength() ==
+                   templateEnds_[slot] - templateStarts_[slot]);
+            assert(scorer->Template() == Template(strands_[slot],
+                                                  templateStarts_[slot],
+                                                  templateEnds_[slot]));
+        }
+        assert(usage == usage_);
+        assert(rankedSlots_.empty() || (int)rankedSlots_.size() == numReads);
+        if (quiverConfig_.MaximumCoverage > 0 && (int)coverage_.size() == TemplateLength())
+        {
+            std::vector<int> coverage(TemplateLength(), 0);
+            for (int slot = 0; slot < numReads; slot++)
+            {
+                for (int pos = templateStarts_[slot]; active_[slot] && pos < templateEnds_[slot]; pos++)
+                {
+                    coverage[pos]++;
+                }
+            }
+            assert(coverage == coverage_);
         }
 #endif  // !NDEBUG
     }
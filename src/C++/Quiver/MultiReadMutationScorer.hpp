@@ -28,18 +28,33 @@
 #pragma once
 
 #include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <map>
 #include <string>
+#include <utility>
 #include <vector>
-#include <map>
 
 #include "Types.hpp"
 #include "Quiver/MappedRead.hpp"
 #include "Quiver/MutationScorer.hpp"
 #include "Quiver/QuiverConfig.hpp"
 #include "Quiver/SseRecursor.hpp"
+#include "Quiver/TemplateView.hpp"
 
 namespace ConsensusCore {
 
+    /// \brief Counts of the work done by FastScore and FastIsFavorable.
+    struct FastScoreCounters
+    {
+        long Mutations;       // mutations scored
+        long ReadsSpanning;   // reads spanning those mutations
+        long ReadsEvaluated;  // reads actually scored
+
+        FastScoreCounters()
+            : Mutations(0), ReadsSpanning(0), ReadsEvaluated(0)
+        {}
+    };
+
     template<typename R>
     class MultiReadMutationScorer : private boost::noncopyable
     {
@@ -62,25 +77,132 @@ namespace ConsensusCore {
         // Reads provided must be clipped to the reference/scaffold window implied by the
         // template, however they need not span the window entirely---nonspanning reads
         // must be provided with (0-based) template start/end coordinates.
-        void AddRead(const QvSequenceFeatures& features, StrandEnum strand);
-        void AddRead(const QvSequenceFeatures& features, StrandEnum strand,
-                     int templateStart, int templateEnd);
-        void AddRead(const MappedRead& mappedRead);
+        //
+        // Each read is given a stable ID: the number of reads added
+        // before it.  AddRead returns it.
+        int AddRead(const QvSequenceFeatures& features, StrandEnum strand);
+        int AddRead(const QvSequenceFeatures& features, StrandEnum strand,
+                    int templateStart, int templateEnd);
+        int AddRead(const MappedRead& mappedRead);
+
+        // Remove a read, given its ID.  The IDs of the other reads are
+        // unchanged, and are not reused.
+        void RemoveRead(int readId);
+
+        // Add bases to either end of the template, or remove them.  The
+        // reads keep their alignments (and filled matrices), re-anchored
+        // to the new template coordinates; when trimming, reads no
+        // longer contained in the template are removed, and their IDs
+        // returned.  Together these let a scorer slide along a
+        // reference, keeping the reads spanning adjacent windows.
+        void ExtendTemplate(const std::string& leftBases, const std::string& rightBases);
+        std::vector<int> TrimTemplate(int leftLength, int rightLength);
+
+        // Add a batch of reads, filling them in parallel on
+        // QuiverConfig::NumThreads threads (or deferring the fills if
+        // QuiverConfig::LazyFill is set).  The scores are the same as if
+        // the reads had been added one at a time, as are the IDs.
+        void AddReads(const std::vector<MappedRead>& mappedReads);
 
         float Score(const Mutation& m) const;
+
+        // FastScore and FastIsFavorable bound how much a mutation could
+        // raise each read's score, from the few template columns it
+        // changes, and stop scoring reads as soon as the bounds on the
+        // remaining reads show the mutation is unfavorable.
+        // FastIsFavorable always agrees with IsFavorable.  FastScore
+        // agrees with Score for mutations scoring above
+        // QuiverConfig::FastScoreThreshold (or zero, whichever is lower),
+        // and otherwise returns an upper bound below it.
         float FastScore(const Mutation& m) const;
 
-        // Return a vector (of length NumReads) of the difference in
+        // Return a vector, indexed by read ID, of the difference in
         // the score of each read caused by the template mutation.  In
         // the case where the mutation cannot be scored for a read
-        // (i.e., it is too close to the end of the template, or the
-        // read does not span the mutation site) that entry in the
-        // vector is -FLT_MAX, which is to be interpreted as NA.
+        // (i.e., the read does not span the mutation site) that entry
+        // in the vector is -FLT_MAX, which is to be interpreted as NA;
+        // likewise for removed reads.
         std::vector<float> Scores(const Mutation& m) const;
 
         bool IsFavorable(const Mutation& m) const;
         bool FastIsFavorable(const Mutation& m) const;
 
+        // Score a batch of mutations, returning the same values as
+        // Score.  The reads are scored in parallel, on
+        // QuiverConfig::NumThreads threads.
+        std::vector<float> Score(const std::vector<Mutation>& mutations) const;
+
+        // Phred-scaled quality values for each base of the template:
+        // the probability of error at a position is the likelihood of
+        // all the templates differing from it by a single-base mutation
+        // there, relative to it.  Insertions after the last base count
+        // towards the last base.  All the mutations are scored in one
+        // batch (see above).
+        std::vector<int> ConsensusQVs() const;
+
+        const FastScoreCounters& Counters() const;
+        void ResetCounters();
+
+        // With QuiverConfig::CacheScores, the score delta of each read
+        // for each mutation scored is remembered until ApplyMutations
+        // changes the read's template, so that rescoring a mutation only
+        // evaluates the reads near accepted edits.  A read's scores
+        // depend only on its own template span, so the cached scores
+        // stay exact.  The caches count towards MemoryUsage (see below).
+        int NumCachedScores() const;
+
+    public:
+        // With QuiverConfig::LazyFill, a read's alpha and beta matrices
+        // are only filled when a mutation it spans is first scored.
+        // Prefetch fills them ahead of time---for all reads, or for
+        // those overlapping [templateStart, templateEnd)---using
+        // multiple threads where OpenMP is available.  Release frees
+        // them all; they will be refilled on demand.
+        void Prefetch();
+        void Prefetch(int templateStart, int templateEnd);
+        void Release();
+        int NumFilledReads() const;
+
+    public:
+        // With QuiverConfig::MaximumCoverage set, only some of the reads
+        // are active---are scored, and have alpha and beta kept.  The
+        // reads are ranked by template span, then by their alignment
+        // score per base against the template when they were added,
+        // and taken in that order if doing so keeps the coverage of
+        // each template position within the limit.  AddReads,
+        // RemoveRead and TrimTemplate rerun the selection; AddRead
+        // admits its read incrementally, displacing the lowest ranked
+        // active reads it overlaps if it outranks them, so that adding
+        // reads one at a time stays cheap.  ApplyMutations leaves the
+        // selection alone.
+        bool IsActive(int readId) const;
+        int NumActiveReads() const;
+
+    public:
+        // MemoryUsage is the number of bytes held by the reads' alpha
+        // and beta matrices, extend buffers and cached scores (an
+        // estimate, for the latter); PeakMemoryUsage is the most they
+        // have held since construction or the last ResetPeakMemoryUsage.
+        //
+        // With QuiverConfig::MemoryBudget set, room is made before each
+        // read is filled by shedding other reads, lowest ranked first
+        // (see IsActive), so the usage stays within budget as reads are
+        // filled, not just once they all are.  Each new read is filled
+        // once to rank it, and released straight away, before any are
+        // kept filled.  Bulk fills (adding reads, applying mutations,
+        // prefetching) go best ranked first and only shed reads ranked
+        // below the one being filled; the reads that do not fit are made
+        // inactive with DROP_READS, and otherwise left unfilled.
+        // Scoring a mutation releases the matrices (and discards the
+        // cached scores) of whichever reads are lowest ranked, those
+        // spanning the mutation last, to refill them on demand.  A read
+        // is expected to take as much memory as when it was last filled,
+        // so after a template change the usage may briefly exceed the
+        // budget by the difference.
+        long MemoryUsage() const;
+        long PeakMemoryUsage() const;
+        void ResetPeakMemoryUsage();
+
     public:
         // Alternate entry point for C# code, not requiring zillions of object
         // allocations.
@@ -95,15 +217,90 @@ namespace ConsensusCore {
     private:
         void CheckInvariants() const;
 
+        // Number of threads to use for bulk fills.
+        int NumThreads() const;
+        void FillScorers(const std::vector<ScorerType*>& scorers) const;
+
+        // A view of the template span of a read, sharing the template
+        // buffer for its strand with all the other reads.
+        TemplateView TemplateRef(StrandEnum strand, int templateStart, int templateEnd) const;
+
+    private:
+        // The reads that may span m---a superset of the reads that
+        // score it---as a range [first, second) of read slots.
+        std::pair<int, int> ReadsSpanning(const Mutation& m) const;
+        bool ReadScoresMutation(int slot, const Mutation& m) const;
+        Mutation OrientedMutation(int slot, const Mutation& m) const;
+        float ReadScoreDelta(int slot, const Mutation& m) const;
+        float BoundedScore(const Mutation& m, float cutoff) const;
+        void SortReads();
+        void SelectReads();
+        void AdmitRead(int slot);
+        void CountCoverage();
+        void RemoveSlot(int slot);
+        void ReplaceTemplate(const std::string& tpl, int shift);
+
+        // Memory accounting: reads are filled by FillRead (on demand)
+        // and FillRanked (in bulk), which make room within the budget
+        // first; ReleaseSlot and ShedSlot free a read's matrices and
+        // cached scores.  Account must follow any change to a read's
+        // matrices or cache, outside parallel regions, to keep
+        // heldBytes_, usage_ and peakMemoryUsage_ up to date.
+        void FillRead(int slot, int keepStart, int keepEnd) const;
+        void FillRanked(const std::vector<int>& slots);
+        long CacheBytes(int slot) const;
+        void Account(int slot) const;
+        void ReleaseSlot(int slot) const;
+        void ShedSlot(int slot);
+        const std::vector<int>& SlotsByRank() const;
+        void EnforceMemoryBudget();
+        void ReleaseOverBudget(int keepStart, int keepEnd) const;
+        void ReleaseForRoom(long needed, int keepStart, int keepEnd,
+                            int pinFirst, int pinLast) const;
+
     private:
+        typedef std::map<Mutation, float> ScoreCache;
+
         R recursor_;
         QuiverConfig quiverConfig_;
-        std::string fwdTemplate_;
-        std::string revTemplate_;
-        std::map<MappedRead*, ScorerType*> scorerForRead_;
+        boost::shared_ptr<const std::string> fwdTemplate_;
+        boost::shared_ptr<const std::string> revTemplate_;
+
+        // The reads, stored by field in parallel vectors whose slots
+        // are ordered by TemplateStart (ties by read ID), so that the
+        // reads spanning a mutation are found by binary search and
+        // visited in a deterministic order.  maxReadSpan_ is the
+        // longest template span of any read.
+        std::vector<int> readIds_;
+        std::vector<StrandEnum> strands_;
+        std::vector<int> templateStarts_;
+        std::vector<int> templateEnds_;
+        std::vector<ScorerType*> scorers_;
+        // Bounds on the score of any move consuming each base of each
+        // read (see QvEvaluator::ReadBaseScoreUpperBounds), or empty if
+        // the read's score can't be bounded
+        std::vector<std::vector<float> > readBaseBounds_;
+        // See IsActive; readScores_ are the per-base alignment scores
+        // the reads are ranked by.
+        std::vector<bool> active_;
+        std::vector<float> readScores_;
+        // The number of active reads covering each template position,
+        // or empty if it must be recounted.
+        std::vector<int> coverage_;
+        // Score deltas already computed, keyed by oriented mutation
+        mutable std::vector<ScoreCache> scoreCaches_;
+        // The bytes held by each read's matrices and cache, as last
+        // accounted, and their total
+        mutable std::vector<long> heldBytes_;
+        mutable long usage_;
+        // The slots, best ranked first, or empty if they must be ranked
+        // again
+        mutable std::vector<int> rankedSlots_;
+        int maxReadSpan_;
+        int numReadsAdded_;
+        mutable long peakMemoryUsage_;
 
-        typedef std::map<MappedRead*, ScorerType*> map_t;
-        typedef typename map_t::value_type         item_t;
+        mutable FastScoreCounters counters_;
     };
 
     typedef MultiReadMutationScorer<SparseSseQvRecursor> SparseSseQvMultiReadMutationScorer;
@@ -27,7 +27,13 @@
 
 #include "Quiver/MutationScorer.hpp"
 
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <climits>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "Matrix/DenseMatrix.hpp"
 #include "Matrix/SparseMatrix.hpp"
@@ -37,28 +43,92 @@
 #include "Quiver/SseRecursor.hpp"
 #include "Mutation.hpp"
 
+// Number of columns in the extend buffer.  Mutations needing more
+// columns than this are scored by refilling from scratch.
+#define EXTEND_BUFFER_COLUMNS 8
+
+using std::max;
+
 namespace ConsensusCore
 {
     template<typename R>
-    MutationScorer<R>::MutationScorer(const EvaluatorType& evaluator, const R& recursor)
+    MutationScorer<R>::MutationScorer(const EvaluatorType& evaluator, const R& recursor,
+                                      bool lazyFill)
         : evaluator_(new EvaluatorType(evaluator)),
-          recursor_(new R(recursor))
+          recursor_(new R(recursor)),
+          lazyFill_(lazyFill),
+          alpha_(NULL),
+          beta_(NULL),
+          extendBuffer_(NULL),
+          filledBytes_(0),
+          alignmentMoves_(),
+          alignmentMovesValid_(false)
     {
-        // Allocate alpha and beta
-        alpha_ = new MatrixType(evaluator.ReadLength() + 1,
-                                evaluator.TemplateLength() + 1);
-        beta_ = new MatrixType(evaluator.ReadLength() + 1,
-                               evaluator.TemplateLength() + 1);
-        // Buffer where we extend into
-        extendBuffer_ = new MatrixType(evaluator.Read().size() + 1, 2);
         // Initial alpha and beta
-        recursor.FillAlphaBeta(*evaluator_, *alpha_, *beta_);
+        if (!lazyFill_)
+        {
+            Fill();
+        }
+    }
+
+    template<typename R>
+    bool
+    MutationScorer<R>::IsFilled() const
+    {
+        return (alpha_ != NULL);
+    }
+
+    template<typename R>
+    void
+    MutationScorer<R>::Fill() const
+    {
+        if (IsFilled()) return;
+        alpha_ = new MatrixType(evaluator_->ReadLength() + 1,
+                                evaluator_->TemplateLength() + 1);
+        beta_  = new MatrixType(evaluator_->ReadLength() + 1,
+                                evaluator_->TemplateLength() + 1);
+        recursor_->FillAlphaBeta(*evaluator_, *alpha_, *beta_);
+        // Buffer where we extend into
+        extendBuffer_ = new MatrixType(evaluator_->ReadLength() + 1, EXTEND_BUFFER_COLUMNS);
+        filledBytes_ = AllocatedBytes();
+    }
+
+    template<typename R>
+    void
+    MutationScorer<R>::Release() const
+    {
+        delete alpha_;
+        delete beta_;
+        delete extendBuffer_;
+        alpha_ = NULL;
+        beta_  = NULL;
+        extendBuffer_ = NULL;
+    }
+
+    template<typename R>
+    long
+    MutationScorer<R>::AllocatedBytes() const
+    {
+        if (!IsFilled()) return 0;
+        // The extend buffer's columns grow as mutations are scored, so it
+        // is counted at its capacity.
+        long bufferEntries = (long)extendBuffer_->Rows() * extendBuffer_->Columns();
+        long entries = alpha_->AllocatedEntries() + beta_->AllocatedEntries() + bufferEntries;
+        return entries * sizeof(float);
+    }
+
+    template<typename R>
+    long
+    MutationScorer<R>::FilledBytes() const
+    {
+        return filledBytes_;
     }
 
     template<typename R>
     float
     MutationScorer<R>::Score() const
     {
+        Fill();
         return (*beta_)(0, 0);
     }
 
@@ -68,28 +138,56 @@ namespace ConsensusCore
         return evaluator_->Template();
     }
 
+    template<typename R>
+    int
+    MutationScorer<R>::TemplateLength() const
+    {
+        return evaluator_->TemplateLength();
+    }
+
     template<typename R>
     void MutationScorer<R>::Template(std::string tpl)
     {
-        delete alpha_;
-        delete beta_;
+        Template(TemplateView(tpl));
+    }
+
+    template<typename R>
+    void MutationScorer<R>::Template(const TemplateView& tpl)
+    {
+        Template(tpl, !lazyFill_);
+    }
+
+    template<typename R>
+    void MutationScorer<R>::Template(const TemplateView& tpl, bool fill)
+    {
+        Release();
+        alignmentMoves_.clear();
+        alignmentMovesValid_ = false;
+        evaluator_->Template(tpl);
+        if (fill)
+        {
+            Fill();
+        }
+    }
+
+    template<typename R>
+    void MutationScorer<R>::RebindTemplate(const TemplateView& tpl)
+    {
+        assert(tpl.ToString() == evaluator_->Template());
         evaluator_->Template(tpl);
-        alpha_ = new MatrixType(evaluator_->ReadLength() + 1,
-                       evaluator_->TemplateLength() + 1);
-        beta_  = new MatrixType(evaluator_->ReadLength() + 1,
-                       evaluator_->TemplateLength() + 1);
-        recursor_->FillAlphaBeta(*evaluator_, *alpha_, *beta_);
     }
 
     template<typename R>
     const typename R::MatrixType* MutationScorer<R>::Alpha() const
     {
+        Fill();
         return alpha_;
     }
 
     template<typename R>
     const typename R::MatrixType* MutationScorer<R>::Beta() const
     {
+        Fill();
         return beta_;
     }
 
@@ -99,50 +197,151 @@ namespace ConsensusCore
         return evaluator_;
     }
 
+    template<typename R>
+    const std::vector<Move>& MutationScorer<R>::AlignmentMoves() const
+    {
+        if (!alignmentMovesValid_)
+        {
+            Fill();
+            alignmentMoves_ = recursor_->Traceback(*evaluator_, *alpha_);
+            alignmentMovesValid_ = true;
+        }
+        return alignmentMoves_;
+    }
+
     template<typename R>
     const PairwiseAlignment* MutationScorer<R>::Alignment() const
     {
-        return recursor_->Alignment(*evaluator_, *alpha_);
+        return AlignmentFromMoves(evaluator_->Template(),
+                                  evaluator_->Read(),
+                                  AlignmentMoves());
     }
 
     template<typename R>
     float MutationScorer<R>::ScoreMutation(const Mutation& m) const
     {
-        // For now, we cannot score mutations too close to the
-        // boundaries of the template. For mutations by the bounds,
-        // we will just return the unmutated score.
-        if (m.Position() >= 3 && m.Position() <= (int)(Template().length()) - 3)
+        Fill();
+        int I = evaluator_->ReadLength();
+        int newTemplateLength = TemplateLength() + m.LengthDiff();
+
+        // In the interior of the template, we extend alpha from the column
+        // preceding the mutation through the columns of the new template
+        // spanned by the new bases, then link against beta at the first
+        // column past the mutation.  Substitutions and insertions of k
+        // bases need k + 1 extension columns; deletions of any length
+        // need two.
+        int extendStartCol = m.Start() - 1;
+        int extendLength = max(1, (int)m.NewBases().length()) + 1;
+        int absoluteLinkCol = extendStartCol + extendLength;
+        int betaLinkCol = absoluteLinkCol - m.LengthDiff();
+
+        // Near the template bounds there is no room to link, so instead we
+        // extend alpha through the last column, or beta back through the
+        // first.  Mutations near both ends (or with too many new bases for
+        // the extend buffer) are scored by refilling from scratch.
+        bool atBegin = (extendStartCol < 2);
+        bool atEnd = (absoluteLinkCol >= newTemplateLength);
+        int bufferColumns = extendBuffer_->Columns();
+
+        TemplateView oldTpl = evaluator_->TemplateRef();
+        std::string newTpl = ApplyMutation(m, oldTpl.ToString());
+
+        // The evaluator class needs to be rethought.  It is a bit
+        // awkward the way we use it.  As Pat has pointed out, it
+        // probably makes more sense to break out the template string
+        // from the read data, as the way we operate is: change
+        // template, check score, repeat---the read data is never
+        // modified.
+        evaluator_->Template(newTpl);
+
+        float score;
+        if (!atBegin && !atEnd && extendLength <= bufferColumns)
+        {
+            recursor_->ExtendAlpha(*evaluator_, *alpha_, extendStartCol,
+                                   *extendBuffer_, extendLength);
+            score = recursor_->LinkAlphaBeta(*evaluator_,
+                                             *extendBuffer_, extendLength,
+                                             *beta_, betaLinkCol,
+                                             absoluteLinkCol);
+        }
+        else if (!atBegin && atEnd &&
+                 newTemplateLength - extendStartCol + 1 <= bufferColumns)
         {
-            std::string oldTpl = evaluator_->Template();
-            std::string newTpl = ApplyMutation(m, oldTpl);
-
-            // The evaluator class needs to be rethought.  It is a bit
-            // awkward the way we use it.  As Pat has pointed out, it
-            // probably makes more sense to break out the template string
-            // from the read data, as the way we operate is: change
-            // template, check score, repeat---the read data is never
-            // modified.
-            evaluator_->Template(newTpl);
-
-            int startCol = m.Position() - 1;
-            int templateCol = m.Position();
-            int betaCol = templateCol + 1 - m.LengthDiff();
-            int alphaLinkCol = 2;
-
-            recursor_->ExtendAlpha(*evaluator_, *alpha_, startCol, *extendBuffer_);
-            float score = recursor_->LinkAlphaBeta(*evaluator_,
-                                                   *extendBuffer_, alphaLinkCol,
-                                                   *beta_, betaCol,
-                                                   templateCol + 1);
-
-            // Restore the original template.
-            evaluator_->Template(oldTpl);
-            return score;
+            extendLength = newTemplateLength - extendStartCol + 1;
+            recursor_->ExtendAlpha(*evaluator_, *alpha_, extendStartCol,
+                                   *extendBuffer_, extendLength);
+            score = (*extendBuffer_)(I, extendLength - 1);
+        }
+        else if (atBegin && !atEnd &&
+                 m.Start() + (int)m.NewBases().length() + 1 <= bufferColumns)
+        {
+            int extendLastCol = m.Start() + m.NewBases().length();
+            recursor_->ExtendBeta(*evaluator_, *beta_, extendLastCol,
+                                  *extendBuffer_, m.LengthDiff());
+            score = (*extendBuffer_)(0, 0);
         }
         else
         {
-            return Score();
+            MatrixType alpha(I + 1, newTemplateLength + 1);
+            MatrixType beta(I + 1, newTemplateLength + 1);
+            recursor_->FillAlphaBeta(*evaluator_, alpha, beta);
+            score = beta(0, 0);
         }
+
+        // Restore the original template.
+        evaluator_->Template(oldTpl);
+        return score;
+    }
+
+    template<typename R>
+    float
+    MutationScorer<R>::ScoreMutationUpperBound(const Mutation& m,
+                                               const std::vector<float>& readBaseBounds) const
+    {
+        Fill();
+        int I = evaluator_->ReadLength();
+        int newTemplateLength = TemplateLength() + m.LengthDiff();
+        assert((int)readBaseBounds.size() == I);
+
+        // The extension and link of ScoreMutation
+        int extendStartCol = m.Start() - 1;
+        int extendLength = max(1, (int)m.NewBases().length()) + 1;
+        int absoluteLinkCol = extendStartCol + extendLength;
+        int betaLinkCol = absoluteLinkCol - m.LengthDiff();
+        if (extendStartCol < 2 || absoluteLinkCol >= newTemplateLength ||
+            extendLength > extendBuffer_->Columns())
+        {
+            return FLT_MAX;
+        }
+
+        // Any path through the mutated template leaves alpha from column
+        // extendStartCol - 1 (or - 2, by a merge), and joins beta at
+        // column betaLinkCol (or + 1), consuming the read bases [i, k) in
+        // between; only the columns between depend on the mutation.  So
+        // the score is at most the best of
+        //     alpha(i) + readBaseBounds[i..k) + beta(k),
+        // taking the better of the two columns on either side, which is
+        // found in one pass down the rows.
+        const MatrixType& alpha = *alpha_;
+        const MatrixType& beta = *beta_;
+        std::pair<int, int> hull = std::make_pair(INT_MAX, 0);
+        hull = RangeUnion(hull, alpha.UsedRowRange(extendStartCol - 2));
+        hull = RangeUnion(hull, alpha.UsedRowRange(extendStartCol - 1));
+        hull = RangeUnion(hull, beta.UsedRowRange(betaLinkCol));
+        hull = RangeUnion(hull, beta.UsedRowRange(betaLinkCol + 1));
+
+        float reach = -FLT_MAX;
+        float bound = -FLT_MAX;
+        for (int i = hull.first; i < hull.second; i++)
+        {
+            if (i > hull.first)
+            {
+                reach += readBaseBounds[i - 1];
+            }
+            reach = max(reach, max(alpha(i, extendStartCol - 2), alpha(i, extendStartCol - 1)));
+            bound = max(bound, reach + max(beta(i, betaLinkCol), beta(i, betaLinkCol + 1)));
+        }
+        return max(bound, -FLT_MAX);
     }
 
     template<typename R>
@@ -156,9 +355,7 @@ namespace ConsensusCore
     template<typename R>
     MutationScorer<R>::~MutationScorer()
     {
-        delete extendBuffer_;
-        delete beta_;
-        delete alpha_;
+        Release();
         delete recursor_;
         delete evaluator_;
     }
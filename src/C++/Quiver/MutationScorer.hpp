@@ -29,12 +29,14 @@
 
 #include <boost/noncopyable.hpp>
 #include <string>
+#include <vector>
 
 // TODO(dalexander): how can we remove this include??
 //  We should move all template instantiations out to another
 //  header, I presume.
 #include "Quiver/SimpleRecursor.hpp"
 #include "Quiver/SseRecursor.hpp"
+#include "Quiver/TemplateView.hpp"
 #include "Types.hpp"
 #include "Mutation.hpp"
 
@@ -49,16 +51,58 @@ namespace ConsensusCore
         typedef R                         RecursorType;
 
     public:
-        MutationScorer(const EvaluatorType& evaluator, const R& recursor);
+        // A lazy scorer defers filling alpha and beta until they are
+        // first needed, and again after each template change.
+        MutationScorer(const EvaluatorType& evaluator, const R& recursor,
+                       bool lazyFill = false);
         virtual ~MutationScorer();
 
     public:
         std::string Template() const;
+        int TemplateLength() const;
         void Template(std::string tpl);
+#ifndef SWIG
+        void Template(const TemplateView& tpl);
+        // As above, but filling now or not regardless of laziness.
+        void Template(const TemplateView& tpl, bool fill);
+        // Switch to an identical copy of the template (in another
+        // buffer, say), keeping alpha, beta and the alignment.
+        void RebindTemplate(const TemplateView& tpl);
+#endif  // SWIG
         float Score() const;
         float ScoreMutation(const Mutation& m) const;
         float ScoreMutation(MutationType mutationType, int position, char base) const;
 
+        // An upper bound on ScoreMutation(m) under Viterbi scoring, given
+        // bounds on the score of any move consuming each read base (and
+        // provided no move consuming none scores above zero).  It costs
+        // one pass down the stored alpha and beta columns either side of
+        // those the mutation changes.  FLT_MAX where ScoreMutation would
+        // not link alpha to beta.
+        float ScoreMutationUpperBound(const Mutation& m,
+                                      const std::vector<float>& readBaseBounds) const;
+
+    public:
+        // Explicit control over the alpha and beta matrices (and the
+        // buffer mutations are scored in): Fill computes them if they
+        // are not already present, Release frees them.  Scoring a
+        // released scorer fills it again.
+        bool IsFilled() const;
+        void Fill() const;
+        void Release() const;
+
+        // Bytes held by the matrices and buffer, and the bytes they held
+        // when last filled (0 if never), which is what refilling against
+        // the same template will take.
+        long AllocatedBytes() const;
+        long FilledBytes() const;
+
+    public:
+        // The optimal alignment of the read to the template as a list of
+        // moves (see RecursorBase::Traceback).  It is computed on first
+        // request and retained until the template changes.
+        const std::vector<Move>& AlignmentMoves() const;
+
     public:
         // Accessors that are handy for debugging.
         const MatrixType* Alpha() const;
@@ -69,9 +113,13 @@ namespace ConsensusCore
     private:
         EvaluatorType* evaluator_;
         R* recursor_;
-        MatrixType* alpha_;
-        MatrixType* beta_;
-        MatrixType* extendBuffer_;
+        bool lazyFill_;
+        mutable MatrixType* alpha_;
+        mutable MatrixType* beta_;
+        mutable MatrixType* extendBuffer_;
+        mutable long filledBytes_;
+        mutable std::vector<Move> alignmentMoves_;
+        mutable bool alignmentMovesValid_;
     };
 
     typedef MutationScorer<SimpleQvRecursor>       SimpleQvMutationScorer;
@@ -78,10 +78,22 @@ namespace ConsensusCore {
     QuiverConfig::QuiverConfig(const QvModelParams& qvParams,
                                int movesAvailable,
                                const BandingOptions& bandingOptions,
-                               float fastScoreThreshold)
+                               float fastScoreThreshold,
+                               bool lazyFill,
+                               int numThreads,
+                               bool cacheScores,
+                               int maximumCoverage,
+                               long memoryBudget,
+                               MemoryPolicy overBudgetPolicy)
         : QvParams(qvParams),
           Banding(bandingOptions),
           MovesAvailable(movesAvailable),
-          FastScoreThreshold(fastScoreThreshold)
+          FastScoreThreshold(fastScoreThreshold),
+          LazyFill(lazyFill),
+          NumThreads(numThreads),
+          CacheScores(cacheScores),
+          MaximumCoverage(maximumCoverage),
+          MemoryBudget(memoryBudget),
+          OverBudgetPolicy(overBudgetPolicy)
     {}
 }
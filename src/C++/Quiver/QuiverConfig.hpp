@@ -115,16 +115,50 @@ namespace ConsensusCore
     };
 
 
+    /// \brief What a MultiReadMutationScorer does when over its memory budget
+    enum MemoryPolicy
+    {
+        // Free the matrices of the least valuable reads, to be
+        // recomputed when next needed
+        RELEASE_MATRICES,
+        // Stop scoring the least valuable reads altogether
+        DROP_READS
+    };
+
+
     struct QuiverConfig
     {
         const QvModelParams QvParams;
         const int MovesAvailable;
         const BandingOptions Banding;
+        // FastScore returns the exact score of any mutation scoring above
+        // this (or above zero, if it is positive); below it, FastScore
+        // may stop early with an upper bound.
         const float FastScoreThreshold;
+        // Defer each read's alpha/beta fill until it is first scored.
+        const bool LazyFill;
+        // Threads used to fill reads in bulk; 0 means the OpenMP default.
+        const int NumThreads;
+        // Retain per-read mutation scores across ApplyMutations, except for
+        // reads whose template span an applied mutation touches.
+        const bool CacheScores;
+        // Score with at most this many reads covering any template
+        // position (see MultiReadMutationScorer); 0 means no limit.
+        const int MaximumCoverage;
+        // Bytes the reads' matrices may occupy (0 means no limit), and
+        // how the limit is kept.
+        const long MemoryBudget;
+        const MemoryPolicy OverBudgetPolicy;
 
         QuiverConfig(const QvModelParams& qvParams,
                      int movesAvailable,
                      const BandingOptions& bandingOptions,
-                     float fastScoreThreshold);
+                     float fastScoreThreshold,
+                     bool lazyFill = false,
+                     int numThreads = 0,
+                     bool cacheScores = false,
+                     int maximumCoverage = 0,
+                     long memoryBudget = 0,
+                     MemoryPolicy overBudgetPolicy = RELEASE_MATRICES);
     };
 }
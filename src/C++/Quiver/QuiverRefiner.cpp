@@ -0,0 +1,206 @@
+// Copyright (c) 2011, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE CONSTITUTES AND EMBODIES PACIFIC BIOSCIENCES' CONFIDENTIAL
+// AND PROPRIETARY INFORMATION.
+//
+// Disclosure, redistribution and use of this software is subject to the
+// terms and conditions of the applicable written agreement(s) between you
+// and Pacific Biosciences, where "you" refers to you or your company or
+// organization, as applicable.  Any other disclosure, redistribution or
+// use is prohibited.
+//
+// THIS SOFTWARE IS PROVIDED BY PACIFIC BIOSCIENCES AND ITS CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "Quiver/QuiverRefiner.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Mutation.hpp"
+#include "Quiver/MultiReadMutationScorer.hpp"
+#include "Utils.hpp"
+
+using std::max;
+using std::min;
+
+namespace ConsensusCore
+{
+    // Orders candidates (by index) by decreasing score.
+    class MutationScoreGreaterThan
+    {
+    public:
+        explicit MutationScoreGreaterThan(const std::vector<float>& scores)
+            : scores_(scores)
+        {}
+
+        bool operator()(int m1, int m2) const
+        {
+            return scores_[m1] > scores_[m2];
+        }
+
+    private:
+        const std::vector<float>& scores_;
+    };
+
+    template<typename R>
+    QuiverRefiner<R>::QuiverRefiner(MultiReadMutationScorer<R>& scorer,
+                                    const RefineOptions& options)
+        : scorer_(scorer),
+          options_(options),
+          converged_(false),
+          numIterations_(0),
+          numMutationsApplied_(0)
+    {}
+
+    template<typename R>
+    bool QuiverRefiner<R>::Refine()
+    {
+        converged_ = false;
+        numIterations_ = 0;
+        numMutationsApplied_ = 0;
+
+        std::set<std::string> templatesSeen;
+        templatesSeen.insert(scorer_.Template());
+        std::vector<Mutation> candidates =
+            UniqueSingleBaseMutations(scorer_.Template(), 0, scorer_.TemplateLength(),
+                                      options_.CandidateTypes);
+        while (numIterations_ < options_.MaximumIterations)
+        {
+            numIterations_++;
+            std::vector<float> scores = scorer_.Score(candidates);
+            std::vector<Mutation> selected = SelectMutations(candidates, scores);
+            if (selected.empty())
+            {
+                converged_ = true;
+                break;
+            }
+
+            std::vector<Mutation*> mutations;
+            foreach (Mutation& m, selected)
+            {
+                mutations.push_back(&m);
+            }
+            std::vector<int> mtp = TargetToQueryPositions(mutations, scorer_.Template());
+            scorer_.ApplyMutations(mutations);
+            numMutationsApplied_ += selected.size();
+
+            // A template seen before means the refinement is cycling.
+            if (!templatesSeen.insert(scorer_.Template()).second)
+            {
+                break;
+            }
+
+            std::vector<int> sites;
+            foreach (const Mutation& m, selected)
+            {
+                sites.push_back(mtp[m.Start()]);
+            }
+            candidates = Candidates(sites);
+        }
+        return converged_;
+    }
+
+    template<typename R>
+    std::vector<Mutation>
+    QuiverRefiner<R>::Candidates(std::vector<int> sites) const
+    {
+        std::string tpl = scorer_.Template();
+        int tplLength = tpl.length();
+        int nbhd = options_.MutationNeighborhood;
+        std::sort(sites.begin(), sites.end());
+
+        // Merge the neighborhoods of the sites into disjoint regions.
+        std::vector<Mutation> candidates;
+        int i = 0;
+        while (i < static_cast<int>(sites.size()))
+        {
+            int start = max(0, sites[i] - nbhd);
+            int end   = min(tplLength, sites[i] + nbhd);
+            for (i++; i < static_cast<int>(sites.size()) && sites[i] - nbhd <= end; i++)
+            {
+                end = min(tplLength, sites[i] + nbhd);
+            }
+            std::vector<Mutation> regionCandidates =
+                UniqueSingleBaseMutations(tpl, start, end, options_.CandidateTypes);
+            candidates.insert(candidates.end(), regionCandidates.begin(), regionCandidates.end());
+        }
+        return candidates;
+    }
+
+    template<typename R>
+    std::vector<Mutation>
+    QuiverRefiner<R>::SelectMutations(const std::vector<Mutation>& candidates,
+                                      const std::vector<float>& scores) const
+    {
+        std::vector<int> favorable;
+        for (int i = 0; i < static_cast<int>(candidates.size()); i++)
+        {
+            if (scores[i] > options_.MinimumScoreGain)
+            {
+                favorable.push_back(i);
+            }
+        }
+        std::stable_sort(favorable.begin(), favorable.end(), MutationScoreGreaterThan(scores));
+
+        // Take the best mutations first, skipping any that would interact
+        // with one already taken.
+        int separation = max(1, options_.MutationSeparation);
+        std::vector<Mutation> selected;
+        foreach (int i, favorable)
+        {
+            const Mutation& m = candidates[i];
+            bool isolated = true;
+            foreach (const Mutation& other, selected)
+            {
+                if (std::abs(m.Start() - other.Start()) < separation)
+                {
+                    isolated = false;
+                    break;
+                }
+            }
+            if (isolated)
+            {
+                selected.push_back(m);
+            }
+        }
+        return selected;
+    }
+
+    template<typename R>
+    bool QuiverRefiner<R>::Converged() const
+    {
+        return converged_;
+    }
+
+    template<typename R>
+    int QuiverRefiner<R>::NumIterations() const
+    {
+        return numIterations_;
+    }
+
+    template<typename R>
+    int QuiverRefiner<R>::NumMutationsApplied() const
+    {
+        return numMutationsApplied_;
+    }
+
+
+    template class QuiverRefiner<SparseSseQvRecursor>;
+}
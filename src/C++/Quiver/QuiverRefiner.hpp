@@ -0,0 +1,102 @@
+// Copyright (c) 2011, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE CONSTITUTES AND EMBODIES PACIFIC BIOSCIENCES' CONFIDENTIAL
+// AND PROPRIETARY INFORMATION.
+//
+// Disclosure, redistribution and use of this software is subject to the
+// terms and conditions of the applicable written agreement(s) between you
+// and Pacific Biosciences, where "you" refers to you or your company or
+// organization, as applicable.  Any other disclosure, redistribution or
+// use is prohibited.
+//
+// THIS SOFTWARE IS PROVIDED BY PACIFIC BIOSCIENCES AND ITS CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <boost/noncopyable.hpp>
+#include <string>
+#include <vector>
+
+#include "Mutation.hpp"
+#include "Quiver/MultiReadMutationScorer.hpp"
+#include "Quiver/SseRecursor.hpp"
+
+namespace ConsensusCore
+{
+    /// \brief Options controlling QuiverRefiner
+    struct RefineOptions
+    {
+        // Give up after this many rounds
+        int MaximumIterations;
+        // Mutations accepted in the same round start at least this far apart
+        int MutationSeparation;
+        // After the first round, candidates are only tried within this
+        // distance of the mutations accepted in the previous round
+        int MutationNeighborhood;
+        // A mutation is accepted only if it raises the score by more than this
+        float MinimumScoreGain;
+        // Bitwise-or of CandidateMutationTypes
+        int CandidateTypes;
+
+        RefineOptions(int maximumIterations    = 40,
+                      int mutationSeparation   = 10,
+                      int mutationNeighborhood = 20,
+                      float minimumScoreGain   = 0,
+                      int candidateTypes       = ALL_CANDIDATES)
+            : MaximumIterations(maximumIterations),
+              MutationSeparation(mutationSeparation),
+              MutationNeighborhood(mutationNeighborhood),
+              MinimumScoreGain(minimumScoreGain),
+              CandidateTypes(candidateTypes)
+        {}
+    };
+
+    /// \brief Iteratively refines the template of a MultiReadMutationScorer.
+    ///
+    /// Each round scores the candidate mutations, applies the favorable
+    /// ones (best first, skipping any too close to one already taken),
+    /// and stops once a round finds none---convergence---or revisits a
+    /// template, or runs out of rounds.  Candidates are scored on the
+    /// scorer's QuiverConfig::NumThreads threads.
+    template<typename R>
+    class QuiverRefiner : private boost::noncopyable
+    {
+    public:
+        QuiverRefiner(MultiReadMutationScorer<R>& scorer,
+                      const RefineOptions& options = RefineOptions());
+
+        // Run the refinement, returning whether it converged.
+        bool Refine();
+
+        bool Converged() const;
+        int NumIterations() const;
+        int NumMutationsApplied() const;
+
+    private:
+        std::vector<Mutation> Candidates(std::vector<int> sites) const;
+        std::vector<Mutation> SelectMutations(const std::vector<Mutation>& candidates,
+                                              const std::vector<float>& scores) const;
+
+    private:
+        MultiReadMutationScorer<R>& scorer_;
+        RefineOptions options_;
+        bool converged_;
+        int numIterations_;
+        int numMutationsApplied_;
+    };
+
+    typedef QuiverRefiner<SparseSseQvRecursor> SparseSseQvQuiverRefiner;
+}
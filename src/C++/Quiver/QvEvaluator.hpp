@@ -39,10 +39,12 @@
 #include <iostream>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Quiver/detail/SseMath.hpp"
 #include "Quiver/QuiverConfig.hpp"
 #include "Quiver/PBFeatures.hpp"
+#include "Quiver/TemplateView.hpp"
 #include "Types.hpp"
 #include "Utils.hpp"
 
@@ -79,6 +81,20 @@ namespace ConsensusCore
               pinEnd_(pinEnd)
         {}
 
+#ifndef SWIG
+        QvEvaluator(const QvSequenceFeatures& features,
+                    const TemplateView& tpl,
+                    const QvModelParams& params,
+                    bool pinStart = true,
+                    bool pinEnd = true)
+            : features_(features),
+              params_(params),
+              tpl_(tpl),
+              pinStart_(pinStart),
+              pinEnd_(pinEnd)
+        {}
+#endif  // SWIG
+
         ~QvEvaluator()
         {}
 
@@ -89,13 +105,25 @@ namespace ConsensusCore
 
         std::string Template() const
         {
-            return tpl_;
+            return tpl_.ToString();
         }
 
         void Template(std::string tpl)
+        {
+            tpl_ = TemplateView(tpl);
+        }
+
+#ifndef SWIG
+        const TemplateView& TemplateRef() const
+        {
+            return tpl_;
+        }
+
+        void Template(const TemplateView& tpl)
         {
             tpl_ = tpl;
         }
+#endif  // SWIG
 
 
         int ReadLength() const
@@ -105,7 +133,7 @@ namespace ConsensusCore
 
         int TemplateLength() const
         {
-            return tpl_.length();
+            return tpl_.Length();
         }
 
         bool PinEnd() const
@@ -179,6 +207,33 @@ namespace ConsensusCore
             NotYetImplemented();
         }
 
+        /// \brief Upper bounds on the score of any move consuming each
+        ///        read base, against any template.
+        ///
+        /// Each read base is consumed by exactly one incorporation, extra
+        /// or merge; deletions consume none, and can only lower the score
+        /// unless the parameters reward them, in which case there is no
+        /// useful bound and the result is empty.
+        std::vector<float> ReadBaseScoreUpperBounds() const
+        {
+            std::vector<float> bounds;
+            for (int i = 0; i < ReadLength(); i++)
+            {
+                if (params_.DeletionN > 0 ||
+                    params_.DeletionWithTag + params_.DeletionWithTagS * features_.DelQv[i] > 0)
+                {
+                    return std::vector<float>();
+                }
+                float best = max(params_.Match,
+                                 params_.Mismatch + params_.MismatchS * features_.SubsQv[i]);
+                best = max(best, params_.Branch + params_.BranchS * features_.InsQv[i]);
+                best = max(best, params_.Nce + params_.NceS * features_.InsQv[i]);
+                best = max(best, params_.Merge + params_.MergeS * features_.MergeQv[i]);
+                bounds.push_back(best);
+            }
+            return bounds;
+        }
+
         //
         // SSE
         //
@@ -262,7 +317,7 @@ namespace ConsensusCore
     protected:
         QvSequenceFeatures features_;
         QvModelParams params_;
-        std::string tpl_;
+        TemplateView tpl_;
         bool pinStart_;
         bool pinEnd_;
     };
@@ -315,25 +315,37 @@ namespace ConsensusCore {
     }
 
 
+    /// Compute numExtColumns columns of alpha, beginning at beginColumn,
+    /// against the (possibly mutated) template in e, storing them in ext.
+    /// Columns prior to beginColumn are read from alpha.  The new template
+    /// may be longer than the one alpha was filled against, in which case
+    /// the row range of alpha's last column is used as the band for the
+    /// columns beyond it.
     template<typename M, typename E, typename C>
     void
     SimpleRecursor<M, E, C>::ExtendAlpha(const E& e,
                                          const M& alpha,
                                          int beginColumn,
-                                         M& ext) const
+                                         M& ext,
+                                         int numExtColumns) const
     {
         assert(alpha.Rows() == e.ReadLength() + 1);
         // The new template may not be the same length as the old template.
         // Just make sure that we have anough room to fill out the extend buffer
-        assert(beginColumn + 1 < e.TemplateLength() + 1);
-        assert(ext.Rows() == e.ReadLength() + 1 && ext.Columns() == 2);
+        assert(beginColumn + numExtColumns < e.TemplateLength() + 2);
+        assert(ext.Rows() == e.ReadLength() + 1 && ext.Columns() >= numExtColumns);
         assert (beginColumn >= 2);
 
-        for (int extCol = 0; extCol < 2; extCol++)
+        for (int extCol = 0; extCol < numExtColumns; extCol++)
         {
             int j = beginColumn + extCol;
             int beginRow, endRow;
-            boost::tie(beginRow, endRow) = alpha.UsedRowRange(j);
+            boost::tie(beginRow, endRow) = alpha.UsedRowRange(min(j, alpha.Columns() - 1));
+            if (j == e.TemplateLength())
+            {
+                // The final column must reach the terminal cell.
+                endRow = e.ReadLength() + 1;
+            }
 
             ext.StartEditingColumn(extCol, beginRow, endRow);
 
@@ -383,7 +395,9 @@ namespace ConsensusCore {
                 // Merge:
                 if ((this->movesAvailable_ & MERGE) && j > 1 && i > 0)
                 {
-                    float prev = alpha(i - 1, j - 2);
+                    float prev = extCol < 2 ?
+                            alpha(i - 1, j - 2) :
+                            ext(i - 1, extCol - 2);
                     thisMoveScore = prev + e.Merge(i - 1, j - 2);
                     score = C::Combine(score, thisMoveScore);
                 }
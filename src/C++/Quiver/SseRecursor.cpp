@@ -414,20 +414,28 @@ namespace ConsensusCore {
     SseRecursor<M, E, C>::ExtendAlpha(const E& e,
                                       const M& alpha,
                                       int beginColumn,
-                                      M& ext) const
+                                      M& ext,
+                                      int numExtColumns) const
     {
         assert(alpha.Rows() == e.ReadLength() + 1);
         // The new template may not be the same length as the old template.
         // Just make sure that we have anough room to fill out the extend buffer
-        assert(beginColumn + 1 < e.TemplateLength() + 1);
-        assert(ext.Rows() == e.ReadLength() + 1 && ext.Columns() == 2);
+        assert(beginColumn + numExtColumns < e.TemplateLength() + 2);
+        assert(ext.Rows() == e.ReadLength() + 1 && ext.Columns() >= numExtColumns);
         assert (beginColumn >= 2);
 
-        for (int extCol = 0; extCol < 2; extCol++)
+        for (int extCol = 0; extCol < numExtColumns; extCol++)
         {
             int j = beginColumn + extCol;
             int beginRow, endRow;
-            boost::tie(beginRow, endRow) = alpha.UsedRowRange(j);
+            // Columns past the end of alpha (possible when the new
+            // template is longer) borrow the band of alpha's last column.
+            boost::tie(beginRow, endRow) = alpha.UsedRowRange(min(j, alpha.Columns() - 1));
+            if (j == e.TemplateLength())
+            {
+                // The final column must reach the terminal cell.
+                endRow = e.ReadLength() + 1;
+            }
 
             ext.StartEditingColumn(extCol, beginRow, endRow);
             int i;
@@ -450,7 +458,9 @@ namespace ConsensusCore {
                     // Merge
                     if (this->movesAvailable_ & MERGE)
                     {
-                        prev = alpha(i - 1, j - 2);
+                        prev = (extCol < 2 ?
+                                    alpha(i - 1, j - 2) :
+                                    ext(i - 1, extCol - 2));
                         score = C::Combine(score, prev + e.Merge(i - 1, j - 2));
                     }
                 }
@@ -474,7 +484,9 @@ namespace ConsensusCore {
                 // Merge
                 if ((this->movesAvailable_ & MERGE) && j >= 2)
                 {
-                    prev4 = alpha.Get4(i - 1, j - 2);
+                    prev4 = (extCol < 2 ?
+                                alpha.Get4(i - 1, j - 2) :
+                                ext.Get4(i - 1, extCol - 2));
                     score4 = C::Combine4(score4, prev4 + e.Merge4(i - 1, j - 2));
                 }
 
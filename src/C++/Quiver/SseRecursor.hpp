@@ -52,7 +52,8 @@ namespace ConsensusCore {
         void ExtendAlpha(const E& e,
                          const M& alpha,
                          int beginColumn,
-                         M& ext) const;
+                         M& ext,
+                         int numExtColumns = 2) const;
 
     public:
         //
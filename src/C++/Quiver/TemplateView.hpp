@@ -0,0 +1,85 @@
+// Copyright (c) 2011, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE CONSTITUTES AND EMBODIES PACIFIC BIOSCIENCES' CONFIDENTIAL
+// AND PROPRIETARY INFORMATION.
+//
+// Disclosure, redistribution and use of this software is subject to the
+// terms and conditions of the applicable written agreement(s) between you
+// and Pacific Biosciences, where "you" refers to you or your company or
+// organization, as applicable.  Any other disclosure, redistribution or
+// use is prohibited.
+//
+// THIS SOFTWARE IS PROVIDED BY PACIFIC BIOSCIENCES AND ITS CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <boost/shared_ptr.hpp>
+#include <cassert>
+#include <string>
+
+namespace ConsensusCore
+{
+    /// \brief A read-only window onto a template string.
+    ///
+    /// The underlying buffer is reference counted, so many views (one
+    /// per read, say) can share a single copy of the template.  A view
+    /// constructed from a plain string owns a private copy of it.
+    class TemplateView
+    {
+    public:
+        TemplateView()
+            : buffer_(new std::string()),
+              data_(buffer_->data()),
+              length_(0)
+        {}
+
+        explicit TemplateView(const std::string& tpl)
+            : buffer_(new std::string(tpl)),
+              data_(buffer_->data()),
+              length_(tpl.length())
+        {}
+
+        TemplateView(const boost::shared_ptr<const std::string>& buffer,
+                     int start, int length)
+            : buffer_(buffer),
+              data_(buffer->data() + start),
+              length_(length)
+        {
+            assert(0 <= start && 0 <= length &&
+                   start + length <= static_cast<int>(buffer->length()));
+        }
+
+        char operator[](int j) const
+        {
+            return data_[j];
+        }
+
+        int Length() const
+        {
+            return length_;
+        }
+
+        std::string ToString() const
+        {
+            return std::string(data_, length_);
+        }
+
+    private:
+        boost::shared_ptr<const std::string> buffer_;
+        const char* data_;
+        int length_;
+    };
+}
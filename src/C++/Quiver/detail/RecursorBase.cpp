@@ -53,6 +53,50 @@ using std::min;
 
 
 namespace ConsensusCore {
+
+    const PairwiseAlignment*
+    AlignmentFromMoves(const std::string& target,
+                       const std::string& query,
+                       const std::vector<Move>& moves)
+    {
+        std::string alnTarget;
+        std::string alnQuery;
+        alnTarget.reserve(target.length() + query.length());
+        alnQuery.reserve(target.length() + query.length());
+
+        int i = 0;
+        int j = 0;
+        foreach (Move move, moves)
+        {
+            switch (move) {
+            case INCORPORATE:
+                alnTarget += target[j++];
+                alnQuery  += query[i++];
+                break;
+            case EXTRA:
+            case BURST:
+                alnTarget += '-';
+                alnQuery  += query[i++];
+                break;
+            case DELETE:
+                alnTarget += target[j++];
+                alnQuery  += '-';
+                break;
+            case MERGE:
+                alnTarget += target[j++];
+                alnTarget += target[j++];
+                alnQuery  += '-';
+                alnQuery  += query[i++];
+                break;
+            default:
+                ShouldNotReachHere();
+            }
+        }
+        assert(i == (int)query.length() && j == (int)target.length());
+
+        return new PairwiseAlignment(alnTarget, alnQuery);
+    }
+
 namespace detail {
 
     template<typename M, typename E, typename C>
@@ -85,6 +129,70 @@ namespace detail {
         }
     }
 
+    // Entry (i, j) of the extended beta matrix: columns up to lastColumn
+    // live in ext, later ones are unchanged from the original beta.
+    template<typename M>
+    static inline float
+    extendedBeta(const M& beta, const M& ext, int lastColumn, int lengthDiff, int i, int j)
+    {
+        return (j <= lastColumn ? ext(i, j) : beta(i, j - lengthDiff));
+    }
+
+    template<typename M, typename E, typename C>
+    void
+    RecursorBase<M, E, C>::ExtendBeta(const E& e, const M& beta, int lastColumn,
+                                      M& ext, int lengthDiff) const
+    {
+        int I = e.ReadLength();
+        int J = e.TemplateLength();
+
+        assert(beta.Rows() == I + 1 && beta.Columns() == J + 1 - lengthDiff);
+        assert(ext.Rows() == I + 1 && ext.Columns() > lastColumn);
+        assert(0 <= lastColumn && lastColumn < J);
+
+        // This is only used for the handful of columns at the start of the
+        // template, so we fill them unbanded and don't bother with SSE.
+        for (int j = lastColumn; j >= 0; --j)
+        {
+            ext.StartEditingColumn(j, 0, I + 1);
+            for (int i = I; i >= 0; --i)
+            {
+                float score = lfloat();
+
+                // Incorporation:
+                if (i < I)
+                {
+                    score = C::Combine(score,
+                                       extendedBeta(beta, ext, lastColumn, lengthDiff, i + 1, j + 1) +
+                                       e.Inc(i, j));
+                }
+                // Extra:
+                if (i < I)
+                {
+                    score = C::Combine(score, ext(i + 1, j) + e.Extra(i, j));
+                }
+                // Delete:
+                score = C::Combine(score,
+                                   extendedBeta(beta, ext, lastColumn, lengthDiff, i, j + 1) +
+                                   e.Del(i, j));
+                // Merge:
+                if ((movesAvailable_ & MERGE) && j < J - 1 && i < I)
+                {
+                    score = C::Combine(score,
+                                       extendedBeta(beta, ext, lastColumn, lengthDiff, i + 1, j + 2) +
+                                       e.Merge(i, j));
+                }
+                // Burst:
+                if (movesAvailable_ & BURST)
+                {
+                    NotYetImplemented();
+                }
+                ext.Set(i, j, score);
+            }
+            ext.FinishEditingColumn(j, 0, I + 1);
+        }
+    }
+
     struct MoveSpec {
         Move MoveType;
         int ReadDelta;
@@ -92,8 +200,8 @@ namespace detail {
     };
 
     template<typename M, typename E, typename C>
-    const PairwiseAlignment*
-    RecursorBase<M, E, C>::Alignment(const E& e, const M& a) const
+    std::vector<Move>
+    RecursorBase<M, E, C>::Traceback(const E& e, const M& a) const
     {
         if (!boost::is_same<C, ViterbiCombiner>::value)
         {
@@ -115,7 +223,7 @@ namespace detail {
         MoveSpec delMove   = { DELETE,      0, 1 };
         MoveSpec extraMove = { EXTRA,       1, 0 };
         MoveSpec mergeMove = { MERGE,       1, 2 };
-        std::vector<MoveSpec> moves;
+        std::vector<Move> moves;
 
         while (i > 0 || j > 0)
         {
@@ -203,7 +311,9 @@ namespace detail {
             assert(bestMove.MoveType != INVALID_MOVE);
             assert(bestMoveScore != lfloat());
 
-            moves.push_back(bestMove);
+            // A burst is recorded as one BURST move per read base.
+            int moveCount = (bestMove.MoveType == BURST ? bestMove.ReadDelta : 1);
+            moves.insert(moves.end(), moveCount, bestMove.MoveType);
             i -= bestMove.ReadDelta;
             j -= bestMove.ReferenceDelta;
             pathScore += bestMoveScore;
@@ -212,52 +322,14 @@ namespace detail {
 
         // Reverse moves
         std::reverse(moves.begin(), moves.end());
+        return moves;
+    }
 
-        // Replay moves and stringify.
-        std::string target;
-        std::string query;
-        i = 0;
-        j = 0;
-        foreach (const MoveSpec& move, moves)
-        {
-            switch (move.MoveType) {
-            case INCORPORATE:
-                target     += e.Template()[j];
-                query      += e.Read()[i];
-                break;
-            case EXTRA:
-                target     += '-';
-                query      += e.Read()[i];
-                break;
-            case DELETE:
-                target     += e.Template()[j];
-                query      += '-';
-                break;
-            case MERGE:
-                target     += e.Template()[j];
-                target     += e.Template()[j+1];
-                query      += '-';
-                query      += e.Read()[i];
-                break;
-            case BURST:
-                for (int z = 0; z < move.ReadDelta; z++)
-                {
-                    target     += '-';
-                    query      += e.Read()[i + z];
-                }
-                break;
-            case INVALID_MOVE:
-                ShouldNotReachHere();
-                break;
-            default:
-                ShouldNotReachHere();
-            }
-            i += move.ReadDelta;
-            j += move.ReferenceDelta;
-            assert(target.length() == query.length());
-        }
-
-        return new PairwiseAlignment(target, query);
+    template<typename M, typename E, typename C>
+    const PairwiseAlignment*
+    RecursorBase<M, E, C>::Alignment(const E& e, const M& a) const
+    {
+        return AlignmentFromMoves(e.Template(), e.Read(), Traceback(e, a));
     }
 
     template<typename M, typename E, typename C>
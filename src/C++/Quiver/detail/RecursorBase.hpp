@@ -30,6 +30,7 @@
 #include <algorithm>
 #include <utility>
 #include <string>
+#include <vector>
 
 #include "Types.hpp"
 #include "Quiver/QuiverConfig.hpp"
@@ -53,6 +54,14 @@ namespace ConsensusCore {
                               std::max(range1.second, range2.second));
     }
 
+
+    /// Build the alignment of query to target described by a list of moves,
+    /// as produced by RecursorBase::Traceback.
+    const PairwiseAlignment*
+    AlignmentFromMoves(const std::string& target,
+                       const std::string& query,
+                       const std::vector<Move>& moves);
+
     namespace detail {
 
     /// \brief A base class for recursors, providing some functionality
@@ -93,10 +102,23 @@ namespace ConsensusCore {
         ///        Client code should use FillAlphaBeta.
         virtual void FillBeta(const E& e, const M& guide, M& beta) const = 0;
 
-        /// \brief Compute two columns of the alpha matrix starting at columnBegin,
-        ///        storing the output in ext.
-        virtual void ExtendAlpha(const E& e, const M& alphaIn, int columnBegin, M& ext) const = 0;
-
+        /// \brief Compute numExtColumns columns of the alpha matrix starting at
+        ///        columnBegin, storing the output in ext.
+        virtual void ExtendAlpha(const E& e, const M& alphaIn, int columnBegin, M& ext,
+                                 int numExtColumns = 2) const = 0;
+
+        /// \brief Compute columns lastColumn, lastColumn - 1, ..., 0 of the
+        ///        beta matrix, storing them in the same columns of ext.
+        ///        Columns past lastColumn are read from betaIn, whose
+        ///        template is lengthDiff bases shorter than e's.
+        void ExtendBeta(const E& e, const M& betaIn, int lastColumn, M& ext,
+                        int lengthDiff = 0) const;
+
+        /// \brief Read out the optimal path through the computed alpha matrix,
+        ///        as a list of moves starting from the beginning of the
+        ///        template.  A burst of k read bases appears as k consecutive
+        ///        BURST moves.
+        std::vector<Move> Traceback(const E& e, const M& alpha) const;
 
         /// \brief Read out the alignment from the computed alpha matrix.
         const PairwiseAlignment* Alignment(const E& e, const M& alpha) const;
@@ -0,0 +1,53 @@
+
+
+from timeit import *
+from random import Random
+from ConsensusCore import *
+
+# Timing of POA consensus on growing numbers of reads, local and
+# global.  Reads are noisy copies of a random template; under local
+# alignment they are also trimmed at random, as subreads would be.
+
+TPL_LENGTH = 500
+READ_COUNTS = [5, 10, 20, 40, 80, 160]
+ITERS = 3
+
+rng = Random(42)
+tpl = "".join(rng.choice("ACGT") for _ in range(TPL_LENGTH))
+
+def noisy_copy(seq, errorRate=0.1):
+    out = []
+    for base in seq:
+        r = rng.random()
+        if r < errorRate / 3:
+            continue                                   # deletion
+        elif r < 2 * errorRate / 3:
+            out.append(rng.choice("ACGT"))             # substitution
+        elif r < errorRate:
+            out.append(rng.choice("ACGT") + base)      # insertion
+        else:
+            out.append(base)
+    return "".join(out)
+
+def trimmed(seq):
+    start = rng.randint(0, len(seq) / 5)
+    end = len(seq) - rng.randint(0, len(seq) / 5)
+    return seq[start:end]
+
+allReads = [noisy_copy(tpl) for _ in range(max(READ_COUNTS))]
+allTrimmedReads = [trimmed(read) for read in allReads]
+
+def find_consensus(reads, local):
+    PoaConsensus.FindConsensus(reads, PoaConfig(local))
+
+def time_per(reads, local):
+    t = Timer(lambda: find_consensus(reads, local))
+    return t.timeit(number = ITERS) / ITERS
+
+
+print "Summary: (template length = %d;  %d iterations)" % (TPL_LENGTH, ITERS)
+print "  %6s  %12s  %12s" % ("Reads", "Global", "Local")
+for n in READ_COUNTS:
+    globalTime = time_per(allReads[:n], PoaConfig.GLOBAL_ALIGNMENT)
+    localTime = time_per(allTrimmedReads[:n], PoaConfig.LOCAL_ALIGNMENT)
+    print "  %6d  %8f sec  %8f sec" % (n, globalTime, localTime)
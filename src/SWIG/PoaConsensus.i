@@ -16,3 +16,8 @@ using namespace ConsensusCore;
 %newobject *::FindConsensus(const std::vector<std::string>& reads);
 
 %include <Poa/PoaConsensus.hpp>
+
+namespace std {
+    %template(PoaWindowVector)          std::vector<ConsensusCore::PoaWindow>;
+    %template(PoaWindowConsensusVector) std::vector<ConsensusCore::PoaWindowConsensus>;
+};
@@ -5,6 +5,7 @@
 #include "Quiver/MultiReadMutationScorer.hpp"
 #include "Quiver/MutationScorer.hpp"
 #include "Quiver/QuiverConfig.hpp"    
+#include "Quiver/QuiverRefiner.hpp"
 #include "Quiver/SimpleRecursor.hpp"
 #include "Quiver/SseRecursor.hpp"
 #include "Sequence.hpp"
@@ -13,14 +14,26 @@ using namespace ConsensusCore;
 
 %include "Sequence.hpp"
 %include "Mutation.hpp"
+%include "Quiver/QuiverConfig.hpp"
+
+namespace std {
+    %template(MoveVector) std::vector<ConsensusCore::Move>;
+    %template(MutationValueVector) std::vector<ConsensusCore::Mutation>;
+};
+
 %include "Quiver/MappedRead.hpp"
+
+namespace std {
+    %template(MappedReadVector) std::vector<ConsensusCore::MappedRead>;
+};
+
 %include "Quiver/detail/Combiner.hpp"
 %include "Quiver/detail/RecursorBase.hpp"
 %include "Quiver/MultiReadMutationScorer.hpp"
 %include "Quiver/MutationScorer.hpp"
-%include "Quiver/QuiverConfig.hpp"
 %include "Quiver/SimpleRecursor.hpp"
 %include "Quiver/SseRecursor.hpp"
+%include "Quiver/QuiverRefiner.hpp"
 
 
 namespace ConsensusCore {
@@ -43,6 +56,7 @@ namespace ConsensusCore {
     %template(SparseSseQvMutationScorer)      MutationScorer<SparseSseQvRecursor>;
 
     %template(SparseSseQvMultiReadMutationScorer) MultiReadMutationScorer<SparseSseQvRecursor>;
+    %template(SparseSseQvQuiverRefiner)           QuiverRefiner<SparseSseQvRecursor>;
 
 	//
 	// Edna evaluator support
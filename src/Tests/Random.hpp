@@ -135,13 +135,14 @@ RandomSampleWithoutReplacement(RNG& rng, int n, int k)
     // Random sample of k elements from [0..n) without replacement
     std::vector<int> draws;
     boost::random::uniform_int_distribution<> indexDist(0, n - 1);
-    while (draws.size() < k) {
+    while ((int)draws.size() < k) {
         int draw = indexDist(rng);
         if (std::find(draws.begin(), draws.end(), draw) == draws.end())
         {
             draws.push_back(draw);
         }
     }
+    return draws;
 }
 
 template<typename RNG>
@@ -153,22 +154,24 @@ RandomTemplateMutations(RNG& rng, std::string tpl, int k)
     const char* bases = "ACGT";
     boost::random::uniform_int_distribution<> baseIndexDist(0, 3);
 
-    const MutationType mutTypes = { ConsensusCore::INSERTION,
-                                    ConsensusCore::SUBSTITUTION,
-                                    ConsensusCore::DELETION      };
-    boost::random::uniform_int_distribution<> mutTypeIndexDist(0, 3);
+    const MutationType mutTypes[] = { ConsensusCore::INSERTION,
+                                      ConsensusCore::SUBSTITUTION,
+                                      ConsensusCore::DELETION      };
+    boost::random::uniform_int_distribution<> mutTypeIndexDist(0, 2);
 
     std::vector<int> positions = RandomSampleWithoutReplacement(rng, tpl.length(), k);
     for (int i = 0; i < k; i++)
     {
-        int pos = positions.pop_back();
+        int pos = positions.back();
+        positions.pop_back();
         MutationType type = mutTypes[mutTypeIndexDist(rng)];
         // this doesn't do anything to avoid (Mismatch A->A)'s.
         // not important for now.
         char base = (type == ConsensusCore::DELETION ? '-' : bases[baseIndexDist(rng)]);
-        Mutation mut(pos, type, base);
+        Mutation mut(type, pos, base);
         muts.push_back(mut);
     }
+    return muts;
 }
 
 
@@ -27,10 +27,14 @@
 
 #include <gtest/gtest.h>
 #include <boost/assign.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 #include <string>
 #include <vector>
 
 #include "Mutation.hpp"
+#include "PairwiseAlignment.hpp"
 #include "Sequence.hpp"
 #include "Quiver/MutationScorer.hpp"
 #include "Quiver/MultiReadMutationScorer.hpp"
@@ -41,6 +45,7 @@
 #include "Quiver/SseRecursor.hpp"
 
 #include "ParameterSettings.hpp"
+#include "Random.hpp"
 
 using namespace ConsensusCore;  // NOLINT
 using namespace boost::assign;  // NOLINT
@@ -122,6 +127,137 @@ TYPED_TEST(MutationScorerTest, TemplateMutationWorkflow)
     EXPECT_EQ("GATTAACA", ms.Template());
 }
 
+TYPED_TEST(MutationScorerTest, MultiBaseMutations)
+{
+    //                 0123456789012345
+    std::string tpl = "GATTACAGATTACAGG";
+    QvSequenceFeatures read("GATTACAGATTTACAGG");
+    E ev(read, tpl, this->testingParams_, true, true);
+    MS ms(ev, this->recursor_);
+
+    std::vector<Mutation> muts;
+    muts += Mutation(INSERTION, 10, 10, "TT"),
+            Mutation(INSERTION, 5, 5, "GATC"),
+            Mutation(DELETION, 4, 7, ""),
+            Mutation(DELETION, 9, 11, ""),
+            Mutation(SUBSTITUTION, 7, 10, "CCA"),
+            Mutation(SUBSTITUTION, 3, 5, "AT"),
+            // More new bases than fit in the extend buffer
+            Mutation(INSERTION, 6, 6, "ACGTACGTAC");
+
+    // Scoring a multi-base mutation must agree with refilling
+    // against the mutated template.
+    foreach (const Mutation& m, muts)
+    {
+        E mutatedEv(read, ApplyMutation(m, tpl), this->testingParams_, true, true);
+        MS mutatedMs(mutatedEv, this->recursor_);
+        EXPECT_FLOAT_EQ(mutatedMs.Score(), ms.ScoreMutation(m)) << m.ToString();
+        EXPECT_EQ(tpl, ms.Template());
+    }
+}
+
+TYPED_TEST(MutationScorerTest, MutationsAtEveryPosition)
+{
+    // Mutations anywhere in the template---including right up against
+    // either end---must score the same as refilling against the
+    // mutated template.
+    std::string tpl = "GATTACAGATTACA";
+    QvSequenceFeatures read("GATTACAGATTTACA");
+    E ev(read, tpl, this->testingParams_, true, true);
+    MS ms(ev, this->recursor_);
+
+    std::vector<Mutation> muts;
+    for (int pos = 0; pos <= (int)tpl.length(); pos++)
+    {
+        muts += Mutation(INSERTION, pos, 'C'),
+                Mutation(INSERTION, pos, pos, "AT");
+        if (pos < (int)tpl.length())
+        {
+            muts += Mutation(SUBSTITUTION, pos, 'G'),
+                    Mutation(DELETION, pos, '-');
+        }
+        if (pos + 2 <= (int)tpl.length())
+        {
+            muts += Mutation(SUBSTITUTION, pos, pos + 2, "CG"),
+                    Mutation(DELETION, pos, pos + 2, "");
+        }
+    }
+
+    foreach (const Mutation& m, muts)
+    {
+        E mutatedEv(read, ApplyMutation(m, tpl), this->testingParams_, true, true);
+        MS mutatedMs(mutatedEv, this->recursor_);
+        EXPECT_FLOAT_EQ(mutatedMs.Score(), ms.ScoreMutation(m)) << m.ToString();
+        EXPECT_EQ(tpl, ms.Template());
+    }
+}
+
+TYPED_TEST(MutationScorerTest, MutationsOnShortTemplate)
+{
+    // Too short to extend from either end: falls back to refilling.
+    std::string tpl = "GAT";
+    QvSequenceFeatures read("GAT");
+    E ev(read, tpl, this->testingParams_, true, true);
+    MS ms(ev, this->recursor_);
+
+    Mutation m(SUBSTITUTION, 1, 'T');
+    E mutatedEv(read, ApplyMutation(m, tpl), this->testingParams_, true, true);
+    MS mutatedMs(mutatedEv, this->recursor_);
+    EXPECT_FLOAT_EQ(mutatedMs.Score(), ms.ScoreMutation(m));
+    EXPECT_GT(ms.Score(), ms.ScoreMutation(m));
+}
+
+TYPED_TEST(MutationScorerTest, LazyFillTest)
+{
+    std::string tpl = "GATTACA";
+    QvSequenceFeatures read("GATTTACA");
+    E ev(read, tpl, this->testingParams_, true, true);
+    MS eager(ev, this->recursor_);
+    MS lazy(ev, this->recursor_, true);
+    Mutation m(DELETION, 3, '-');
+
+    EXPECT_TRUE(eager.IsFilled());
+    EXPECT_FALSE(lazy.IsFilled());
+    EXPECT_EQ(eager.Score(), lazy.Score());
+    EXPECT_TRUE(lazy.IsFilled());
+
+    lazy.Release();
+    EXPECT_FALSE(lazy.IsFilled());
+    EXPECT_EQ(eager.ScoreMutation(m), lazy.ScoreMutation(m));
+    EXPECT_TRUE(lazy.IsFilled());
+
+    // A template change discards a lazy scorer's fill.
+    eager.Template("GATTTACA");
+    lazy.Template("GATTTACA");
+    EXPECT_TRUE(eager.IsFilled());
+    EXPECT_FALSE(lazy.IsFilled());
+    EXPECT_EQ(eager.Score(), lazy.Score());
+}
+
+TYPED_TEST(MutationScorerTest, AlignmentMovesTest)
+{
+    std::string tpl = "GATTACA";
+    QvSequenceFeatures read("GATTTACA");
+    E ev(read, tpl, this->testingParams_, true, true);
+    MS ms(ev, this->recursor_);
+
+    const std::vector<Move>& moves = ms.AlignmentMoves();
+    ASSERT_EQ(8, moves.size());
+    EXPECT_EQ(1, std::count(moves.begin(), moves.end(), EXTRA));
+    EXPECT_EQ(7, std::count(moves.begin(), moves.end(), INCORPORATE));
+    EXPECT_EQ(&moves, &ms.AlignmentMoves());
+
+    const PairwiseAlignment* alignment = ms.Alignment();
+    EXPECT_EQ(8, alignment->Length());
+    EXPECT_EQ(1, alignment->Insertions());
+    EXPECT_EQ("GATTTACA", alignment->Query());
+    delete alignment;
+
+    ms.Template("GATTTACA");
+    EXPECT_EQ(8, std::count(ms.AlignmentMoves().begin(),
+                            ms.AlignmentMoves().end(), INCORPORATE));
+}
+
 
 //
 // ================== Tests for MultiReadMutationScorer ===========================
@@ -296,3 +432,738 @@ TYPED_TEST(MultiReadMutationScorerTest, NonSpanningReadsTest1)
     mScorer.ApplyMutations(muts);
     EXPECT_EQ("AATGTTAATCAATTGATTAACATT", mScorer.Template());
 }
+
+
+TYPED_TEST(MultiReadMutationScorerTest, LazyFillTest)
+{
+    // read1:                     >>>>>>>>>>>
+    // read2:          <<<<<<<<<<<
+    //                 0123456789012345678901
+    std::string tpl = "AATGTAATCAATTGATTACATT";
+    QuiverConfig lazyConfig(this->testingConfig_.QvParams,
+                            this->testingConfig_.MovesAvailable,
+                            this->testingConfig_.Banding,
+                            this->testingConfig_.FastScoreThreshold,
+                            true);
+    MMS mScorer(lazyConfig, tpl);
+    mScorer.AddRead(QvSequenceFeatures("TTGATTACATT"), FORWARD_STRAND, 11, 22);
+    mScorer.AddRead(QvSequenceFeatures("TTGATTACATT"), REVERSE_STRAND,  0, 11);
+    EXPECT_EQ(0, mScorer.NumFilledReads());
+
+    // Scoring only touches the reads spanning the mutation.
+    EXPECT_EQ(-10, mScorer.Score(Mutation(SUBSTITUTION, 17, 'T')));
+    EXPECT_EQ(1, mScorer.NumFilledReads());
+
+    mScorer.Release();
+    EXPECT_EQ(0, mScorer.NumFilledReads());
+    mScorer.Prefetch(0, 5);
+    EXPECT_EQ(1, mScorer.NumFilledReads());
+    mScorer.Prefetch();
+    EXPECT_EQ(2, mScorer.NumFilledReads());
+
+    EXPECT_EQ(-10, mScorer.Score(Mutation(SUBSTITUTION, 17, 'T')));
+    EXPECT_EQ(-10, mScorer.Score(Mutation(SUBSTITUTION, 4, 'A')));
+
+    Mutation insertMutation(INSERTION, 17, 'A');
+    std::vector<Mutation*> muts;
+    muts += &insertMutation;
+    mScorer.ApplyMutations(muts);
+    // Only read1's template changed; read2 keeps its matrices.
+    EXPECT_EQ(1, mScorer.NumFilledReads());
+    EXPECT_EQ(0, mScorer.Score(Mutation(SUBSTITUTION, 17, 'A')));
+}
+
+
+TYPED_TEST(MultiReadMutationScorerTest, AddReadsTest)
+{
+    // Adding reads in bulk, on any number of threads, gives exactly the
+    // same scores as adding them one at a time.
+    //                 0123456789012345678901
+    std::string tpl = "AATGTAATCAATTGATTACATT";
+    std::vector<MappedRead> reads;
+    reads += MappedRead(QvSequenceFeatures("TTGATTACATT"), FORWARD_STRAND, 11, 22),
+             MappedRead(QvSequenceFeatures("TTGATTACATT"), REVERSE_STRAND,  0, 11),
+             MappedRead(QvSequenceFeatures("AATGTAATCAATTGATTACATT"), FORWARD_STRAND, 0, 22),
+             MappedRead(QvSequenceFeatures("AATGTAATCATTGATTTACATT"), FORWARD_STRAND, 0, 22),
+             MappedRead(QvSequenceFeatures("AATGTAATCAATTGATTACATT"), REVERSE_STRAND, 0, 22);
+
+    MMS serialScorer(this->testingConfig_, tpl);
+    foreach (const MappedRead& mr, reads)
+    {
+        serialScorer.AddRead(mr);
+    }
+
+    Mutation insertMutation(INSERTION, 17, 'A');
+    std::vector<Mutation*> muts;
+    muts += &insertMutation;
+    std::vector<Mutation> testMutations;
+    testMutations += Mutation(SUBSTITUTION, 4, 'A'),
+                     Mutation(DELETION, 10, '-'),
+                     Mutation(INSERTION, 17, 'T');
+
+    int threadCounts[] = { 1, 2, 4 };
+    foreach (int numThreads, threadCounts)
+    {
+        QuiverConfig config(this->testingConfig_.QvParams,
+                            this->testingConfig_.MovesAvailable,
+                            this->testingConfig_.Banding,
+                            this->testingConfig_.FastScoreThreshold,
+                            false,
+                            numThreads);
+        MMS bulkScorer(config, tpl);
+        bulkScorer.AddReads(reads);
+        EXPECT_EQ(5, bulkScorer.NumReads());
+        EXPECT_EQ(5, bulkScorer.NumFilledReads());
+        EXPECT_EQ(serialScorer.BaselineScore(), bulkScorer.BaselineScore());
+        foreach (const Mutation& m, testMutations)
+        {
+            EXPECT_EQ(serialScorer.Score(m), bulkScorer.Score(m));
+        }
+
+        bulkScorer.ApplyMutations(muts);
+        EXPECT_EQ(5, bulkScorer.NumFilledReads());
+        EXPECT_EQ("AATGTAATCAATTGATTAACATT", bulkScorer.Template());
+    }
+
+    serialScorer.ApplyMutations(muts);
+    QuiverConfig config(this->testingConfig_.QvParams,
+                        this->testingConfig_.MovesAvailable,
+                        this->testingConfig_.Banding,
+                        this->testingConfig_.FastScoreThreshold,
+                        false,
+                        3);
+    MMS bulkScorer(config, tpl);
+    bulkScorer.AddReads(reads);
+    bulkScorer.ApplyMutations(muts);
+    EXPECT_EQ(serialScorer.BaselineScore(), bulkScorer.BaselineScore());
+    foreach (const Mutation& m, testMutations)
+    {
+        EXPECT_EQ(serialScorer.Score(m), bulkScorer.Score(m));
+    }
+}
+
+
+TYPED_TEST(MultiReadMutationScorerTest, ReadIndexTest)
+{
+    // Staggered reads of different lengths; each mutation must be scored
+    // by exactly the reads whose span contains it, before and after the
+    // template is mutated.
+    //                 0123456789012345678901234567890
+    std::string tpl = "AATGTAATCAATTGATTACATTGCAGGTACT";
+    MMS mScorer(this->testingConfig_, tpl);
+    int starts[] = { 12,  0, 5, 20, 3,  9 };
+    int ends[]   = { 31, 11, 9, 31, 30, 17 };
+    for (int r = 0; r < 6; r++)
+    {
+        EXPECT_EQ(r, mScorer.AddRead(QvSequenceFeatures(tpl.substr(starts[r], ends[r] - starts[r])),
+                                     FORWARD_STRAND, starts[r], ends[r]));
+    }
+
+    for (int pos = 0; pos < (int)tpl.length(); pos++)
+    {
+        Mutation m(SUBSTITUTION, pos, tpl[pos] == 'A' ? 'C' : 'A');
+        std::vector<float> scores = mScorer.Scores(m);
+        ASSERT_EQ(6, scores.size());
+
+        // Scores are indexed by read ID, the order of addition.
+        float sum = 0;
+        for (int r = 0; r < 6; r++)
+        {
+            bool spans = (starts[r] <= pos && pos < ends[r]);
+            EXPECT_EQ(spans, scores[r] != -FLT_MAX) << pos << " " << r;
+            if (spans) sum += scores[r];
+        }
+        EXPECT_FLOAT_EQ(sum, mScorer.Score(m));
+    }
+
+    Mutation insertMutation(INSERTION, 10, 'G');
+    std::vector<Mutation*> muts;
+    muts += &insertMutation;
+    mScorer.ApplyMutations(muts);
+
+    // The read [0, 11) now ends at 12, and [12, 31) starts at 13.
+    Mutation m(SUBSTITUTION, 11, 'T');
+    std::vector<float> scores = mScorer.Scores(m);
+    EXPECT_EQ(-FLT_MAX, scores[0]);
+    EXPECT_NE(-FLT_MAX, scores[1]);
+    EXPECT_EQ(-FLT_MAX, scores[2]);
+    EXPECT_EQ(-FLT_MAX, scores[3]);
+    EXPECT_NE(-FLT_MAX, scores[4]);
+    EXPECT_NE(-FLT_MAX, scores[5]);
+}
+
+
+TYPED_TEST(MultiReadMutationScorerTest, FastScoreTest)
+{
+    // The template has an error (the missing T) relative to the reads.
+    //                    0123456789012345678901
+    std::string truth  = "AATGTAATCAATTGATTACATT";
+    std::string tpl    = "AATGTAATCAATGATTACATT";
+    MMS mScorer(this->testingConfig_, tpl);
+    mScorer.AddRead(QvSequenceFeatures(truth), FORWARD_STRAND);
+    mScorer.AddRead(QvSequenceFeatures(ReverseComplement(truth)), REVERSE_STRAND);
+    mScorer.AddRead(QvSequenceFeatures(truth), FORWARD_STRAND);
+    mScorer.AddRead(QvSequenceFeatures("AATGTAATCAATTGATTACAATT"), FORWARD_STRAND);
+    mScorer.AddRead(QvSequenceFeatures(truth.substr(0, 15)), REVERSE_STRAND, 0, 14);
+
+    std::vector<Mutation> mutations;
+    std::string bases = "ACGT";
+    for (int pos = 0; pos <= (int)tpl.length(); pos++)
+    {
+        foreach (char base, bases)
+        {
+            mutations += Mutation(INSERTION, pos, base);
+            if (pos < (int)tpl.length() && base != tpl[pos])
+            {
+                mutations += Mutation(SUBSTITUTION, pos, base);
+            }
+        }
+        if (pos < (int)tpl.length())
+        {
+            mutations += Mutation(DELETION, pos, '-');
+        }
+    }
+
+    int numFavorable = 0;
+    foreach (const Mutation& m, mutations)
+    {
+        float score = mScorer.Score(m);
+        float fastScore = mScorer.FastScore(m);
+        EXPECT_EQ(mScorer.IsFavorable(m), mScorer.FastIsFavorable(m)) << m.ToString();
+        if (score > 0)
+        {
+            EXPECT_EQ(score, fastScore) << m.ToString();
+            numFavorable++;
+        }
+        else
+        {
+            EXPECT_GE(fastScore + 1e-3, score) << m.ToString();
+            EXPECT_GE(0, fastScore) << m.ToString();
+        }
+    }
+    EXPECT_LT(0, numFavorable);
+
+    // Above FastScoreThreshold, FastScore is exact.
+    const QuiverConfig& cfg = this->testingConfig_;
+    QuiverConfig thresholdConfig(cfg.QvParams, cfg.MovesAvailable, cfg.Banding, -20);
+    MMS thresholdScorer(thresholdConfig, tpl);
+    thresholdScorer.AddRead(QvSequenceFeatures(truth), FORWARD_STRAND);
+    thresholdScorer.AddRead(QvSequenceFeatures(ReverseComplement(truth)), REVERSE_STRAND);
+    thresholdScorer.AddRead(QvSequenceFeatures(truth), FORWARD_STRAND);
+    int numExact = 0;
+    foreach (const Mutation& m, mutations)
+    {
+        float score = thresholdScorer.Score(m);
+        float fastScore = thresholdScorer.FastScore(m);
+        if (score > -20)
+        {
+            EXPECT_EQ(score, fastScore) << m.ToString();
+            numExact++;
+        }
+        else
+        {
+            EXPECT_GE(fastScore + 1e-3, score) << m.ToString();
+            EXPECT_GT(-20, fastScore) << m.ToString();
+        }
+    }
+    EXPECT_LT(0, numExact);
+    EXPECT_GT((int)mutations.size(), numExact);
+
+    // Many mutations are rejected after scoring only some of the reads.
+    const FastScoreCounters& counters = mScorer.Counters();
+    EXPECT_EQ(2 * (long)mutations.size(), counters.Mutations);
+    EXPECT_LT(counters.ReadsEvaluated, counters.ReadsSpanning);
+
+    mScorer.ResetCounters();
+    EXPECT_EQ(0, mScorer.Counters().Mutations);
+    EXPECT_EQ(0, mScorer.Counters().ReadsEvaluated);
+}
+
+
+TYPED_TEST(MultiReadMutationScorerTest, FastScoreNoisyReadsTest)
+{
+    // Reads sampled from the truth with ~15% errors, scored against a
+    // template missing one base of the truth.
+    Rng rng(42);
+    std::string truth = RandomSequence(rng, 400);
+    std::string tpl = truth.substr(0, 200) + truth.substr(201);
+    std::string bases = "ACGT";
+    boost::random::uniform_int_distribution<> baseDist(0, 3);
+
+    MMS mScorer(this->testingConfig_, tpl);
+    for (int n = 0; n < 30; n++)
+    {
+        std::string read;
+        foreach (char base, truth)
+        {
+            if (RandomBernoulliDraw(rng, 0.05)) continue;
+            read += RandomBernoulliDraw(rng, 0.05) ? bases[baseDist(rng)] : base;
+            if (RandomBernoulliDraw(rng, 0.05)) read += bases[baseDist(rng)];
+        }
+        StrandEnum strand = (n % 2 == 0) ? FORWARD_STRAND : REVERSE_STRAND;
+        if (strand == REVERSE_STRAND) read = ReverseComplement(read);
+
+        int len = read.length();
+        float* insQv = RandomQvArray(rng, len);
+        float* subsQv = RandomQvArray(rng, len);
+        float* delQv = RandomQvArray(rng, len);
+        float* delTag = RandomTagArray(rng, len);
+        float* mergeQv = RandomQvArray(rng, len);
+        mScorer.AddRead(QvSequenceFeatures(read, insQv, subsQv, delQv, delTag, mergeQv),
+                        strand);
+        delete[] insQv;
+        delete[] subsQv;
+        delete[] delQv;
+        delete[] delTag;
+        delete[] mergeQv;
+    }
+
+    std::vector<Mutation> mutations;
+    for (int pos = 190; pos < 210; pos++)
+    {
+        foreach (char base, bases)
+        {
+            mutations += Mutation(INSERTION, pos, base);
+            if (base != tpl[pos])
+            {
+                mutations += Mutation(SUBSTITUTION, pos, base);
+            }
+        }
+        mutations += Mutation(DELETION, pos, '-');
+    }
+
+    int numFavorable = 0;
+    foreach (const Mutation& m, mutations)
+    {
+        float score = mScorer.Score(m);
+        float fastScore = mScorer.FastScore(m);
+        EXPECT_EQ(mScorer.IsFavorable(m), mScorer.FastIsFavorable(m)) << m.ToString();
+        if (score > 0)
+        {
+            EXPECT_EQ(score, fastScore) << m.ToString();
+            numFavorable++;
+        }
+        else
+        {
+            EXPECT_GE(fastScore + 1e-2, score) << m.ToString();
+            EXPECT_GE(0, fastScore) << m.ToString();
+        }
+    }
+    EXPECT_LT(0, numFavorable);
+
+    // The bounds reject most mutations without scoring every read.
+    const FastScoreCounters& counters = mScorer.Counters();
+    EXPECT_LT(counters.ReadsEvaluated, counters.ReadsSpanning);
+}
+
+
+TYPED_TEST(MultiReadMutationScorerTest, ScoreCacheTest)
+{
+    //                 0123456789012345678901234567890123456789
+    std::string tpl = "AATGTAATCAATTGATTACATTGCAGTCCATGGATTACAG";
+    const QuiverConfig& cfg = this->testingConfig_;
+    std::vector<MappedRead> reads;
+    reads.push_back(MappedRead(QvSequenceFeatures(tpl.substr(0, 18)),
+                               FORWARD_STRAND, 0, 18));
+    reads.push_back(MappedRead(QvSequenceFeatures(ReverseComplement(tpl.substr(22, 18))),
+                               REVERSE_STRAND, 22, 40));
+    reads.push_back(MappedRead(QvSequenceFeatures(tpl), FORWARD_STRAND, 0, 40));
+
+    QuiverConfig cachingConfig(cfg.QvParams, cfg.MovesAvailable, cfg.Banding,
+                               cfg.FastScoreThreshold, false, 0, true);
+    MMS mScorer(cachingConfig, tpl);
+    mScorer.AddReads(reads);
+    long matrixBytes = mScorer.MemoryUsage();
+
+    // Score every substitution; each read caches a score per
+    // substitution it spans.
+    std::string bases = "ACGT";
+    for (int pos = 0; pos < (int)tpl.length(); pos++)
+    {
+        foreach (char base, bases)
+        {
+            if (base != tpl[pos])
+            {
+                mScorer.Score(Mutation(SUBSTITUTION, pos, base));
+            }
+        }
+    }
+    EXPECT_EQ(3 * (18 + 18 + 40), mScorer.NumCachedScores());
+    EXPECT_LT(matrixBytes, mScorer.MemoryUsage());
+
+    // An edit within the second read leaves the first read's cache
+    // alone.
+    Mutation edit(DELETION, 30, '-');
+    std::vector<Mutation*> edits;
+    edits.push_back(&edit);
+    mScorer.ApplyMutations(edits);
+    std::string newTpl = ApplyMutation(edit, tpl);
+    EXPECT_EQ(newTpl, mScorer.Template());
+    EXPECT_EQ(3 * 18, mScorer.NumCachedScores());
+
+    // The cached scores agree with a fresh scorer's.
+    std::vector<MappedRead> newReads(reads);
+    newReads[1].TemplateEnd = 39;
+    newReads[2] = MappedRead(QvSequenceFeatures(tpl), FORWARD_STRAND, 0, 39);
+    MMS freshScorer(cfg, newTpl);
+    freshScorer.AddReads(newReads);
+    for (int pos = 0; pos < (int)newTpl.length(); pos++)
+    {
+        foreach (char base, bases)
+        {
+            if (base == newTpl[pos]) continue;
+            Mutation m(SUBSTITUTION, pos, base);
+            EXPECT_EQ(freshScorer.Scores(m), mScorer.Scores(m)) << m.ToString();
+            EXPECT_EQ(freshScorer.Score(m), mScorer.Score(m)) << m.ToString();
+            EXPECT_EQ(freshScorer.IsFavorable(m), mScorer.FastIsFavorable(m))
+                << m.ToString();
+        }
+    }
+}
+
+
+TYPED_TEST(MultiReadMutationScorerTest, BatchScoreTest)
+{
+    //                 0123456789012345678901234567890123456789
+    std::string tpl = "AATGTAATCAATTGATTACATTGCAGTCCATGGATTACAG";
+    const QuiverConfig& cfg = this->testingConfig_;
+    QuiverConfig threadedConfig(cfg.QvParams, cfg.MovesAvailable, cfg.Banding,
+                                cfg.FastScoreThreshold, false, 3);
+    MMS mScorer(threadedConfig, tpl);
+    mScorer.AddRead(QvSequenceFeatures(tpl.substr(0, 18)), FORWARD_STRAND, 0, 18);
+    mScorer.AddRead(QvSequenceFeatures(ReverseComplement(tpl.substr(22, 18))),
+                    REVERSE_STRAND, 22, 40);
+    mScorer.AddRead(QvSequenceFeatures("AATGTAATCAATTGATTACATTGCAGTCATGGATTACAG"),
+                    FORWARD_STRAND);
+
+    std::vector<Mutation> mutations;
+    for (int pos = 40; pos >= 0; pos--)
+    {
+        mutations += Mutation(INSERTION, pos, 'G');
+        if (pos < 40)
+        {
+            mutations += Mutation(DELETION, pos, '-');
+            mutations += Mutation(SUBSTITUTION, pos, tpl[pos] == 'A' ? 'C' : 'A');
+        }
+    }
+    std::vector<float> scores = mScorer.Score(mutations);
+    ASSERT_EQ(mutations.size(), scores.size());
+    for (int i = 0; i < (int)mutations.size(); i++)
+    {
+        EXPECT_EQ(mScorer.Score(mutations[i]), scores[i]) << mutations[i].ToString();
+    }
+    EXPECT_TRUE(mScorer.Score(std::vector<Mutation>()).empty());
+}
+
+
+TYPED_TEST(MultiReadMutationScorerTest, CoverageCapTest)
+{
+    //                 0123456789012345678901234567890123456789
+    std::string tpl = "AATGTAATCAATTGATTACATTGCAGTCCATGGATTACAG";
+    std::string bad = "AATGTAATCAATTGATTACATTCCAGTCCATGGATTACAG";
+    const QuiverConfig& cfg = this->testingConfig_;
+    QuiverConfig cappedConfig(cfg.QvParams, cfg.MovesAvailable, cfg.Banding,
+                              cfg.FastScoreThreshold, false, 0, false, 2);
+    MMS mScorer(cappedConfig, tpl);
+    mScorer.AddRead(QvSequenceFeatures(bad), FORWARD_STRAND);
+    mScorer.AddRead(QvSequenceFeatures(ReverseComplement(tpl)), REVERSE_STRAND);
+    EXPECT_EQ(2, mScorer.NumActiveReads());
+
+    // A better read displaces the worse one.
+    mScorer.AddRead(QvSequenceFeatures(tpl), FORWARD_STRAND);
+    EXPECT_EQ(2, mScorer.NumActiveReads());
+    EXPECT_FALSE(mScorer.IsActive(0));
+    EXPECT_TRUE(mScorer.IsActive(1));
+    EXPECT_TRUE(mScorer.IsActive(2));
+    EXPECT_EQ(2, mScorer.NumFilledReads());
+
+    // No room for a shorter read where the coverage is full; ties go
+    // to the reads added first.
+    std::vector<MappedRead> reads;
+    reads.push_back(MappedRead(QvSequenceFeatures(tpl.substr(0, 18)), FORWARD_STRAND, 0, 18));
+    reads.push_back(MappedRead(QvSequenceFeatures(tpl), FORWARD_STRAND, 0, 40));
+    mScorer.AddReads(reads);
+    EXPECT_EQ(2, mScorer.NumActiveReads());
+    EXPECT_FALSE(mScorer.IsActive(3));
+    EXPECT_FALSE(mScorer.IsActive(4));
+
+    // Only the active reads are scored.
+    MMS activeScorer(cfg, tpl);
+    activeScorer.AddRead(QvSequenceFeatures(ReverseComplement(tpl)), REVERSE_STRAND);
+    activeScorer.AddRead(QvSequenceFeatures(tpl), FORWARD_STRAND);
+    Mutation m(SUBSTITUTION, 22, 'C');
+    EXPECT_EQ(activeScorer.Score(m), mScorer.Score(m));
+    EXPECT_EQ(activeScorer.BaselineScore(), mScorer.BaselineScore());
+    std::vector<float> scores = mScorer.Scores(m);
+    EXPECT_EQ(-FLT_MAX, scores[0]);
+    EXPECT_LT(-FLT_MAX, scores[1]);
+    EXPECT_LT(-FLT_MAX, scores[2]);
+    EXPECT_EQ(-FLT_MAX, scores[3]);
+    EXPECT_EQ(-FLT_MAX, scores[4]);
+
+    // Inactive reads follow template changes without being filled.
+    std::vector<Mutation*> muts;
+    muts += &m;
+    mScorer.ApplyMutations(muts);
+    EXPECT_EQ(2, mScorer.NumFilledReads());
+    EXPECT_EQ(2, mScorer.NumActiveReads());
+
+    // Reads added one at a time are admitted against the coverage of
+    // the new template.
+    std::string newTpl = mScorer.Template();
+    EXPECT_EQ(5, mScorer.AddRead(QvSequenceFeatures(newTpl.substr(0, 18)),
+                                 FORWARD_STRAND, 0, 18));
+    EXPECT_FALSE(mScorer.IsActive(5));
+    EXPECT_EQ(2, mScorer.NumFilledReads());
+}
+
+
+TYPED_TEST(MultiReadMutationScorerTest, SlidingWindowTest)
+{
+    //                   0123456789012345678901234567890123456789012345678901234567890
+    std::string truth = "AATGTAATCAATTGATTACATTGCAGTCCATGGATTACAGTTGACCATTGCATGGACTAC";
+    const QuiverConfig& cfg = this->testingConfig_;
+    QuiverConfig lazyConfig(cfg.QvParams, cfg.MovesAvailable, cfg.Banding,
+                            cfg.FastScoreThreshold, true);
+    MMS mScorer(lazyConfig, truth.substr(0, 40));
+    EXPECT_EQ(0, mScorer.AddRead(QvSequenceFeatures(truth.substr(0, 20)),
+                                 FORWARD_STRAND, 0, 20));
+    EXPECT_EQ(1, mScorer.AddRead(QvSequenceFeatures(ReverseComplement(truth.substr(10, 30))),
+                                 REVERSE_STRAND, 10, 40));
+    EXPECT_EQ(2, mScorer.AddRead(QvSequenceFeatures(truth.substr(25, 15)),
+                                 FORWARD_STRAND, 25, 40));
+    mScorer.Prefetch();
+
+    // Slide the window 10 bases right; the reads within it are kept,
+    // filled, and score as in a fresh scorer for the new window.
+    std::vector<int> removed = mScorer.TrimTemplate(10, 0);
+    ASSERT_EQ(1, removed.size());
+    EXPECT_EQ(0, removed[0]);
+    mScorer.ExtendTemplate("", truth.substr(40, 10));
+    EXPECT_EQ(truth.substr(10, 40), mScorer.Template());
+    EXPECT_EQ(2, mScorer.NumReads());
+    EXPECT_EQ(2, mScorer.NumFilledReads());
+
+    MMS freshScorer(cfg, truth.substr(10, 40));
+    freshScorer.AddRead(QvSequenceFeatures(truth.substr(0, 1)), FORWARD_STRAND, 0, 0);
+    freshScorer.AddRead(QvSequenceFeatures(ReverseComplement(truth.substr(10, 30))),
+                        REVERSE_STRAND, 0, 30);
+    freshScorer.AddRead(QvSequenceFeatures(truth.substr(25, 15)), FORWARD_STRAND, 15, 30);
+    freshScorer.RemoveRead(0);
+    EXPECT_EQ(freshScorer.BaselineScore(), mScorer.BaselineScore());
+    for (int pos = 0; pos < 40; pos++)
+    {
+        Mutation m(DELETION, pos, '-');
+        EXPECT_EQ(freshScorer.Scores(m), mScorer.Scores(m)) << m.ToString();
+    }
+
+    // Extending to the left shifts the reads too.
+    mScorer.ExtendTemplate(truth.substr(5, 5), "");
+    EXPECT_EQ(truth.substr(5, 45), mScorer.Template());
+    Mutation m(SUBSTITUTION, 30, 'A');
+    EXPECT_EQ(freshScorer.Scores(Mutation(SUBSTITUTION, 25, 'A')), mScorer.Scores(m));
+
+    // IDs are not reused after removal.
+    mScorer.RemoveRead(2);
+    EXPECT_EQ(1, mScorer.NumReads());
+    EXPECT_EQ(3, mScorer.AddRead(QvSequenceFeatures(truth.substr(20, 10)),
+                                 FORWARD_STRAND, 15, 25));
+    std::vector<float> scores = mScorer.Scores(m);
+    ASSERT_EQ(4, scores.size());
+    EXPECT_EQ(-FLT_MAX, scores[0]);
+    EXPECT_EQ(-FLT_MAX, scores[2]);
+    EXPECT_EQ(-FLT_MAX, scores[3]);
+
+    EXPECT_THROW(mScorer.RemoveRead(2), InvalidInputError);
+    EXPECT_THROW(mScorer.TrimTemplate(40, 10), InvalidInputError);
+}
+
+
+TYPED_TEST(MultiReadMutationScorerTest, ConsensusQVTest)
+{
+    //                   0123456789012345678901234567890123456789
+    std::string truth = "AATGTAATCAATTGATTACATTGCAGTCCATGGATTACAG";
+    std::string tpl   = "AATGTAATCAATTGATTACATTGCTGTCCATGGATTACAG";
+    MMS mScorer(this->testingConfig_, tpl);
+    for (int i = 0; i < 2; i++)
+    {
+        mScorer.AddRead(QvSequenceFeatures(truth), FORWARD_STRAND);
+        mScorer.AddRead(QvSequenceFeatures(ReverseComplement(truth)), REVERSE_STRAND);
+    }
+    std::vector<int> qvs = mScorer.ConsensusQVs();
+    ASSERT_EQ(tpl.length(), qvs.size());
+
+    // The error has QV 0; elsewhere, the QV follows from the scores of
+    // the mutations at each position.
+    EXPECT_EQ(0, qvs[24]);
+    std::vector<int> positions;
+    positions += 0, 5, 12, 30, 39;
+    foreach (int pos, positions)
+    {
+        double sum = 0;
+        foreach (const Mutation& m, UniqueSingleBaseMutations(tpl, pos, pos + 1))
+        {
+            if (m.Start() == pos || pos == (int)tpl.length() - 1)
+            {
+                sum += exp(mScorer.Score(m));
+            }
+        }
+        double qv = std::min(93.0, 10 * log10(1 + 1 / sum));
+        EXPECT_NEAR(qv, qvs[pos], 0.5 + 1e-3) << pos;
+        EXPECT_LT(20, qvs[pos]) << pos;
+    }
+}
+
+
+TYPED_TEST(MultiReadMutationScorerTest, MemoryBudgetTest)
+{
+    //                   0123456789012345678901234567890123456789
+    std::string truth = "AATGTAATCAATTGATTACATTGCAGTCCATGGATTACAG";
+    std::string tpl   = "AATGTAATCAATTGATTACATTGCTGTCCATGGATTACAG";
+    std::vector<MappedRead> reads;
+    for (int i = 0; i < 3; i++)
+    {
+        reads.push_back(MappedRead(QvSequenceFeatures(truth), FORWARD_STRAND, 0, 40));
+        reads.push_back(MappedRead(QvSequenceFeatures(ReverseComplement(truth)),
+                                   REVERSE_STRAND, 0, 40));
+    }
+    reads.push_back(MappedRead(QvSequenceFeatures(truth.substr(0, 20)), FORWARD_STRAND, 0, 20));
+
+    const QuiverConfig& cfg = this->testingConfig_;
+    MMS unlimited(cfg, tpl);
+    unlimited.AddReads(reads);
+    long usage = unlimited.MemoryUsage();
+    EXPECT_LT(0, usage);
+    EXPECT_EQ(usage, unlimited.PeakMemoryUsage());
+    unlimited.Release();
+    EXPECT_EQ(0, unlimited.MemoryUsage());
+    EXPECT_EQ(usage, unlimited.PeakMemoryUsage());
+    unlimited.ResetPeakMemoryUsage();
+    EXPECT_EQ(0, unlimited.PeakMemoryUsage());
+    long budget = usage / 3;
+
+    // Releasing matrices keeps the scores exact.
+    QuiverConfig releaseConfig(cfg.QvParams, cfg.MovesAvailable, cfg.Banding,
+                               cfg.FastScoreThreshold, true, 0, false, 0,
+                               budget, RELEASE_MATRICES);
+    MMS releasing(releaseConfig, tpl);
+    releasing.AddReads(reads);
+    EXPECT_GE(budget, releasing.MemoryUsage());
+    EXPECT_EQ((int)reads.size(), releasing.NumActiveReads());
+    for (int pos = 0; pos < 40; pos++)
+    {
+        Mutation m(DELETION, pos, '-');
+        EXPECT_EQ(unlimited.Score(m), releasing.Score(m)) << m.ToString();
+        EXPECT_GE(budget, releasing.MemoryUsage());
+    }
+    EXPECT_LT(0, releasing.NumFilledReads());
+    EXPECT_GT((int)reads.size(), releasing.NumFilledReads());
+    EXPECT_GE(budget, releasing.PeakMemoryUsage());
+
+    // Dropping reads keeps the best of them.
+    QuiverConfig dropConfig(cfg.QvParams, cfg.MovesAvailable, cfg.Banding,
+                            cfg.FastScoreThreshold, false, 0, false, 0,
+                            budget, DROP_READS);
+    MMS dropping(dropConfig, tpl);
+    dropping.AddReads(reads);
+    EXPECT_GE(budget, dropping.MemoryUsage());
+    EXPECT_GE(budget, dropping.PeakMemoryUsage());
+    EXPECT_LT(0, dropping.NumActiveReads());
+    EXPECT_GT((int)reads.size(), dropping.NumActiveReads());
+    EXPECT_FALSE(dropping.IsActive(6));
+    EXPECT_TRUE(dropping.IsActive(0));
+}
+
+
+TYPED_TEST(MultiReadMutationScorerTest, RemoveReadBudgetTest)
+{
+    // Removing a read lets the coverage selection readmit reads it had
+    // held out; the memory budget still holds afterwards.
+    std::string tpl = "AATGTAATCAATTGATTACATTGCAGTCCATGGATTACAG";
+    std::vector<MappedRead> reads;
+    for (int i = 0; i < 4; i++)
+    {
+        reads.push_back(MappedRead(QvSequenceFeatures(tpl), FORWARD_STRAND, 0, 40));
+    }
+    const QuiverConfig& cfg = this->testingConfig_;
+    MMS single(cfg, tpl);
+    single.AddRead(reads[0]);
+    long budget = single.MemoryUsage() * 3 / 2;
+
+    QuiverConfig tightConfig(cfg.QvParams, cfg.MovesAvailable, cfg.Banding,
+                             cfg.FastScoreThreshold, false, 0, false, 3,
+                             budget, DROP_READS);
+    MMS mScorer(tightConfig, tpl);
+    mScorer.AddReads(reads);
+    EXPECT_EQ(1, mScorer.NumActiveReads());
+    EXPECT_TRUE(mScorer.IsActive(0));
+
+    mScorer.RemoveRead(0);
+    EXPECT_GE(budget, mScorer.MemoryUsage());
+    EXPECT_EQ(1, mScorer.NumActiveReads());
+    EXPECT_TRUE(mScorer.IsActive(1));
+
+    EXPECT_TRUE(mScorer.TrimTemplate(0, 0).empty());
+    EXPECT_GE(budget, mScorer.MemoryUsage());
+    EXPECT_EQ(1, mScorer.NumActiveReads());
+}
+
+
+TYPED_TEST(MultiReadMutationScorerTest, MultiBaseReverseStrandTest)
+{
+    // A multi-base mutation must score the same against a read
+    // on either strand.
+    //                 01234567890123
+    std::string tpl = "TTGATTACATTGCA";
+    Mutation insertMutation(INSERTION, 6, 6, "TT");
+    Mutation deletionMutation(DELETION, 5, 7, "");
+    Mutation substitutionMutation(SUBSTITUTION, 6, 9, "GGG");
+
+    MMS fwdScorer(this->testingConfig_, tpl);
+    fwdScorer.AddRead(QvSequenceFeatures("TTGATTTACATTGCA"), FORWARD_STRAND);
+
+    MMS revScorer(this->testingConfig_, tpl);
+    revScorer.AddRead(QvSequenceFeatures(ReverseComplement("TTGATTTACATTGCA")),
+                      REVERSE_STRAND);
+
+    EXPECT_FLOAT_EQ(fwdScorer.Score(insertMutation), revScorer.Score(insertMutation));
+    EXPECT_FLOAT_EQ(fwdScorer.Score(deletionMutation), revScorer.Score(deletionMutation));
+    EXPECT_FLOAT_EQ(fwdScorer.Score(substitutionMutation),
+                    revScorer.Score(substitutionMutation));
+    EXPECT_NE(0, fwdScorer.Score(substitutionMutation));
+
+    std::vector<Mutation*> muts;
+    muts += &insertMutation;
+    fwdScorer.ApplyMutations(muts);
+    revScorer.ApplyMutations(muts);
+    EXPECT_EQ("TTGATTTTACATTGCA", fwdScorer.Template());
+    EXPECT_FLOAT_EQ(fwdScorer.BaselineScore(), revScorer.BaselineScore());
+}
+
+
+TYPED_TEST(MultiReadMutationScorerTest, TemplateEdgeTest)
+{
+    // Mutations at the very ends of the template are scored by the
+    // reads covering them.
+    std::string tpl = "TTGATTACATT";
+    MMS mScorer(this->testingConfig_, tpl);
+    mScorer.AddRead(QvSequenceFeatures("TTGATTACATT"), FORWARD_STRAND);
+    mScorer.AddRead(QvSequenceFeatures("AATGTAATCAA"), REVERSE_STRAND);
+
+    Mutation noOpMutation(SUBSTITUTION, 0, 'T');
+    Mutation startMutation(SUBSTITUTION, 0, 'G');
+    Mutation endMutation(SUBSTITUTION, 10, 'G');
+    Mutation prependMutation(INSERTION, 0, 'A');
+    Mutation appendMutation(INSERTION, 11, 'A');
+
+    EXPECT_EQ(0, mScorer.Score(noOpMutation));
+    EXPECT_GT(0, mScorer.Score(startMutation));
+    EXPECT_GT(0, mScorer.Score(endMutation));
+    EXPECT_GT(0, mScorer.Score(prependMutation));
+    EXPECT_GT(0, mScorer.Score(appendMutation));
+    EXPECT_FLOAT_EQ(mScorer.Score(startMutation), mScorer.Score(endMutation));
+
+    std::vector<float> scores = mScorer.Scores(startMutation);
+    ASSERT_EQ(2, scores.size());
+    EXPECT_FLOAT_EQ(scores[0], scores[1]);
+}
@@ -160,3 +160,69 @@ TEST(MutationTest, MutatedTemplatePositionsTest)
     int expectedMtp3[] = { 0, 0, 1, 2 };
     ASSERT_THAT(TargetToQueryPositions(muts3, tpl3), ElementsAreArray(expectedMtp3));
 }
+
+TEST(MutationTest, MultiBaseMutationsTest)
+{
+    //            0123456
+    string tpl = "GATTACA";
+    Mutation ins(INSERTION, 3, 3, "TT");
+    Mutation del(DELETION, 2, 4, "");
+    Mutation sub(SUBSTITUTION, 4, 6, "GG");
+
+    EXPECT_EQ("GATTTTACA", ApplyMutation(ins, tpl));
+    EXPECT_EQ("GAACA",     ApplyMutation(del, tpl));
+    EXPECT_EQ("GATTGGA",   ApplyMutation(sub, tpl));
+
+    EXPECT_EQ(2,  ins.LengthDiff());
+    EXPECT_EQ(-2, del.LengthDiff());
+    EXPECT_EQ(0,  sub.LengthDiff());
+    EXPECT_EQ('-', del.Base());
+    EXPECT_EQ('G', sub.Base());
+
+    // Single-base constructors agree with the general form
+    EXPECT_EQ(Mutation(INSERTION, 3, 3, "T"),    Mutation(INSERTION, 3, 'T'));
+    EXPECT_EQ(Mutation(DELETION, 3, 4, ""),      Mutation(DELETION, 3, '-'));
+    EXPECT_EQ(Mutation(SUBSTITUTION, 3, 4, "C"), Mutation(SUBSTITUTION, 3, 'C'));
+
+    std::vector<Mutation*> muts;
+    muts += &sub, &ins;
+    EXPECT_EQ("GATTTTGGA", ApplyMutations(muts, tpl));
+    EXPECT_EQ("MMMIIMRRM", MutationsToTranscript(muts, tpl));
+
+    std::vector<Mutation*> muts2;
+    muts2 += &del;
+    int expectedMtp[] = { 0, 1, 2, 2, 2, 3, 4, 5 };
+    ASSERT_THAT(TargetToQueryPositions(muts2, tpl), ElementsAreArray(expectedMtp));
+}
+
+TEST(MutationTest, InvalidMultiBaseMutationsTest)
+{
+    EXPECT_THROW(Mutation(INSERTION, 3, 4, "A"),     InvalidInputError);
+    EXPECT_THROW(Mutation(DELETION, 3, 3, ""),       InvalidInputError);
+    EXPECT_THROW(Mutation(DELETION, 3, 4, "A"),      InvalidInputError);
+    EXPECT_THROW(Mutation(SUBSTITUTION, 3, 5, "A"),  InvalidInputError);
+    EXPECT_THROW(Mutation(SUBSTITUTION, 3, 5, "AN"), InvalidInputError);
+}
+
+TEST(MutationTest, UniqueSingleBaseMutations)
+{
+    // Insertions of the preceding base, and deletions of any but the
+    // first base of a run, are left out.
+    std::vector<Mutation> mutations = UniqueSingleBaseMutations("AAC", 0, 3);
+    EXPECT_EQ(24, mutations.size());
+    EXPECT_EQ(Mutation(INSERTION, 0, 'A'), mutations[0]);
+    EXPECT_EQ(Mutation(INSERTION, 3, 'T'), mutations.back());
+
+    std::vector<Mutation> deletions = UniqueSingleBaseMutations("AAC", 0, 3,
+                                                                CANDIDATE_DELETIONS);
+    ASSERT_EQ(2, deletions.size());
+    EXPECT_EQ(Mutation(DELETION, 0, '-'), deletions[0]);
+    EXPECT_EQ(Mutation(DELETION, 2, '-'), deletions[1]);
+
+    // Within a window, insertions go up to and including its end.
+    std::vector<Mutation> insertions = UniqueSingleBaseMutations("GATTACA", 2, 4,
+                                                                 CANDIDATE_INSERTIONS);
+    EXPECT_EQ(9, insertions.size());
+    EXPECT_EQ(Mutation(INSERTION, 2, 'C'), insertions[0]);
+    EXPECT_EQ(Mutation(INSERTION, 4, 'G'), insertions.back());
+}
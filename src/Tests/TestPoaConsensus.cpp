@@ -34,14 +34,19 @@
 #include <boost/assign/std/vector.hpp>
 #include <cstdlib>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "Poa/PoaConfig.hpp"
 #include "Poa/PoaConsensus.hpp"
+#include "Quiver/PBFeatures.hpp"
+#include "Quiver/QuiverConfig.hpp"
 #include "Utils.hpp"
 #include "Mutation.hpp"
+#include "ParameterSettings.hpp"
+#include "Random.hpp"
 
 using std::string;
 using std::vector;
@@ -68,6 +73,20 @@ static void plotGraph(const PoaGraph* g, string description, bool REALLY_MAKE_TH
     }
 }
 
+// The consensus sequence of a graph, freeing the variants found with it
+static string consensusSequence(const PoaGraph& graph, const PoaConfig& config)
+{
+    string sequence;
+    vector< std::pair<Mutation*, float> >* variants;
+    boost::tie(sequence, boost::tuples::ignore, variants) = graph.FindConsensus(config);
+    for (unsigned int k = 0; k < variants->size(); k++)
+    {
+        delete (*variants)[k].first;
+    }
+    delete variants;
+    return sequence;
+}
+
 // TEST(PoaGraph, NoReadsTest)
 // {
 //  // Test that it works with no reads
@@ -460,6 +479,133 @@ TEST(PoaConsensus, SmallTilingTest)
     EXPECT_EQ("GGGGAAAATTTTCCCCAGGA", pc->Sequence());
 }
 
+TEST(PoaConsensus, NoisyReadsTest)
+{
+    // Each read carries one error, at a different place; the consensus
+    // should outvote all of them.
+    boost::random::mt19937 rng(42);
+    std::string tpl = RandomSequence(rng, 120);
+    vector<std::string> reads;
+    for (int k = 0; k < 10; k++)
+    {
+        std::string read = tpl;
+        int pos = 10 * k + 7;
+        if (k % 3 == 0)
+        {
+            read[pos] = (read[pos] == 'A' ? 'C' : 'A');
+        }
+        else if (k % 3 == 1)
+        {
+            read.erase(pos, 1);
+        }
+        else
+        {
+            read.insert(pos, 1, (read[pos] == 'G' ? 'T' : 'G'));
+        }
+        reads.push_back(read);
+    }
+    reads.push_back(tpl);
+
+    const PoaConsensus* pc = PoaConsensus::FindConsensus(reads, PoaConfig::GLOBAL_ALIGNMENT);
+    EXPECT_EQ(tpl, pc->Sequence());
+    delete pc;
+
+    pc = PoaConsensus::FindConsensus(reads, PoaConfig::LOCAL_ALIGNMENT);
+    EXPECT_EQ(tpl, pc->Sequence());
+    delete pc;
+}
+
+
+TEST(PoaConsensus, BandedTest)
+{
+    // Banded alignment should find the same consensus as the full
+    // alignment, for reads that stay near the diagonal...
+    boost::random::mt19937 rng(7);
+    std::string tpl = RandomSequence(rng, 200);
+    vector<std::string> reads;
+    for (int k = 0; k < 8; k++)
+    {
+        std::string read = tpl;
+        read.erase(20 * k + 11, 2);
+        read.insert(20 * k + 3, "AC");
+        reads.push_back(read);
+    }
+    PoaParameterSet params = PoaParameterSet::DefaultParameters();
+    bool modes[] = { PoaConfig::GLOBAL_ALIGNMENT, PoaConfig::LOCAL_ALIGNMENT };
+    foreach (bool local, modes)
+    {
+        const PoaConsensus* full = PoaConsensus::FindConsensus(reads, PoaConfig(local));
+        const PoaConsensus* banded = PoaConsensus::FindConsensus(
+            reads, PoaConfig(params, local, PoaConfig::NO_MERGE_MOVE, 8));
+        EXPECT_EQ(full->Sequence(), banded->Sequence());
+        EXPECT_EQ(full->Graph()->ToGraphViz(), banded->Graph()->ToGraphViz());
+        delete full;
+        delete banded;
+    }
+
+    // ... and still thread in reads that run off the band.
+    vector<std::string> offsetReads;
+    offsetReads += "GATTACAGATTACA", "CCCCCCCCCCGATTACAGATTACA", "GATTACAGATTACA";
+    const PoaConsensus* pc = PoaConsensus::FindConsensus(
+        offsetReads, PoaConfig(params, PoaConfig::GLOBAL_ALIGNMENT,
+                               PoaConfig::NO_MERGE_MOVE, 2));
+    EXPECT_EQ("GATTACAGATTACA", pc->Sequence());
+    EXPECT_EQ(3, pc->Graph()->NumSequences());
+    delete pc;
+}
+
+
+TEST(PoaGraph, QvFeaturesTest)
+{
+    // With flat QVs and matching parameters, reads are threaded into
+    // the graph just as with the PoaParameterSet...
+    boost::random::mt19937 rng(42);
+    std::string tpl = RandomSequence(rng, 60);
+    vector<std::string> reads;
+    reads += tpl, tpl.substr(0, 20) + "G" + tpl.substr(20),
+             tpl.substr(0, 30) + tpl.substr(31), tpl.substr(5, 40);
+    PoaParameterSet params = PoaParameterSet::DefaultParameters();
+    QvModelParams qvParams(params.Match, params.Mismatch, 0,
+                           params.Extra, 0, params.Missing, params.Missing, 0,
+                           params.Extra, 0);
+    bool modes[] = { PoaConfig::GLOBAL_ALIGNMENT, PoaConfig::LOCAL_ALIGNMENT };
+    foreach (bool local, modes)
+    {
+        PoaConfig config(params, local);
+        PoaGraph flatGraph, qvGraph;
+        foreach (const std::string& read, reads)
+        {
+            flatGraph.AddSequence(read, config);
+            qvGraph.AddSequence(QvSequenceFeatures(read), qvParams, config);
+        }
+        EXPECT_EQ(flatGraph.ToGraphViz(), qvGraph.ToGraphViz());
+    }
+
+    // ... but otherwise the QVs steer the alignment: here, they decide
+    // which G of the second read is the extra one.
+    QvModelParams insertionParams(0, -10, 0, -1, -1, -2, -2, 0, -1, -1);
+    float lowFirst[]  = { 0, 0, 0, 10, 0 };
+    float lowSecond[] = { 0, 0, 10, 0, 0 };
+    float zeros[]     = { 0, 0, 0, 0, 0 };
+    PoaConfig config(PoaConfig::GLOBAL_ALIGNMENT);
+
+    PoaGraph graph;
+    graph.AddSequence(QvSequenceFeatures("ACGT"), insertionParams, config);
+    graph.AddSequence(QvSequenceFeatures("ACGGT", lowFirst, zeros, zeros, zeros, zeros),
+                      insertionParams, config);
+    string dot = erase_all_copy(graph.ToGraphViz(), "\n");
+    EXPECT_NE(string::npos, dot.find("3->6 ;"));  // C -> new G -> G
+    EXPECT_NE(string::npos, dot.find("6->4 ;"));
+
+    graph.Clear();
+    graph.AddSequence(QvSequenceFeatures("ACGT"), insertionParams, config);
+    graph.AddSequence(QvSequenceFeatures("ACGGT", lowSecond, zeros, zeros, zeros, zeros),
+                      insertionParams, config);
+    dot = erase_all_copy(graph.ToGraphViz(), "\n");
+    EXPECT_NE(string::npos, dot.find("4->6 ;"));  // G -> new G -> T
+    EXPECT_NE(string::npos, dot.find("6->5 ;"));
+}
+
 
 TEST(PoaConsensus, TestVerboseGraphVizOutput)
 {
@@ -521,3 +667,189 @@ TEST(PoaConsensus, TestMutations)
 }
 
 
+
+
+TEST(PoaConsensus, BatchTest)
+{
+    // Each window's consensus, and variants, should come out as if it
+    // were found on its own, however many threads share the windows.
+    boost::random::mt19937 rng(42);
+    vector<PoaWindow> windows;
+    for (int w = 0; w < 12; w++)
+    {
+        std::string tpl = RandomSequence(rng, 40 + 5 * w);
+        vector<std::string> reads;
+        for (int k = 0; k < 3 + w % 4; k++)
+        {
+            std::string read = tpl;
+            int pos = RandomPoissonDraw(rng, tpl.length() / 2) % tpl.length();
+            if (k % 2 == 0)
+            {
+                read.erase(pos, 1);
+            }
+            else
+            {
+                read[pos] = (read[pos] == 'A' ? 'C' : 'A');
+            }
+            reads.push_back(read);
+        }
+        windows.push_back(PoaWindow(100 * w, 100 * w + tpl.length(), reads));
+    }
+
+    for (int numThreads = 1; numThreads <= 4; numThreads += 3)
+    {
+        vector<PoaWindowConsensus> results =
+            PoaConsensus::FindConsensuses(windows, PoaConfig(), numThreads);
+        ASSERT_EQ(windows.size(), results.size());
+        for (unsigned int w = 0; w < windows.size(); w++)
+        {
+            const PoaConsensus* pc = PoaConsensus::FindConsensus(windows[w].Reads);
+            EXPECT_EQ(windows[w].Start, results[w].Start);
+            EXPECT_EQ(windows[w].End, results[w].End);
+            EXPECT_EQ(pc->Sequence(), results[w].Sequence);
+            ASSERT_EQ(pc->Mutations()->size(), results[w].Variants.size());
+            ASSERT_EQ(pc->Mutations()->size(), results[w].VariantScores.size());
+            for (unsigned int k = 0; k < results[w].Variants.size(); k++)
+            {
+                EXPECT_EQ((*pc->Mutations())[k].first->ToString(),
+                          results[w].Variants[k].ToString());
+                EXPECT_EQ((*pc->Mutations())[k].second, results[w].VariantScores[k]);
+            }
+            delete pc;
+        }
+    }
+
+    // A bad window fails the whole batch, however many threads share it.
+    windows[5].Reads.push_back("");
+    for (int numThreads = 1; numThreads <= 4; numThreads += 3)
+    {
+        EXPECT_THROW(PoaConsensus::FindConsensuses(windows, PoaConfig(), numThreads),
+                     InvalidInputError);
+    }
+}
+
+
+TEST(PoaConsensus, PruningTest)
+{
+    // Errors unique to one read leave weakly supported branches, which
+    // pruning should remove without changing the consensus.
+    boost::random::mt19937 rng(42);
+    std::string tpl = RandomSequence(rng, 100);
+    vector<std::string> reads;
+    for (int k = 0; k < 12; k++)
+    {
+        std::string read = tpl;
+        int pos = 8 * k + 3;
+        if (k % 2 == 0)
+        {
+            read[pos] = (read[pos] == 'A' ? 'C' : 'A');
+        }
+        else
+        {
+            read.insert(pos, 1, (read[pos] == 'G' ? 'T' : 'G'));
+        }
+        reads.push_back(read);
+    }
+
+    PoaConfig config(PoaConfig::GLOBAL_ALIGNMENT);
+    PoaGraph graph;
+    foreach (const std::string& read, reads)
+    {
+        graph.AddSequence(read, config);
+    }
+    // Each read's error vertex is spanned by that read and those added
+    // after it, so only the first seven reads' errors fall below 20%.
+    EXPECT_EQ(0, graph.Prune(0));
+    EXPECT_EQ(7, graph.Prune(0.2f));
+    EXPECT_EQ(0, graph.Prune(0.2f));
+    EXPECT_EQ(12, graph.NumSequences());
+    EXPECT_EQ(tpl, consensusSequence(graph, config));
+
+    // Pruning as the graph is built
+    config.PruneInterval = 4;
+    config.PruneFraction = 0.2f;
+    const PoaConsensus* pc = PoaConsensus::FindConsensus(reads, config);
+    EXPECT_EQ(tpl, pc->Sequence());
+    delete pc;
+}
+
+
+TEST(PoaGraph, SaveLoadTest)
+{
+    boost::random::mt19937 rng(42);
+    std::string tpl = RandomSequence(rng, 80);
+    vector<std::string> reads;
+    reads += tpl, tpl.substr(0, 20) + "G" + tpl.substr(20),
+             tpl.substr(0, 30) + tpl.substr(31), tpl.substr(5, 60),
+             tpl.substr(0, 50) + "T" + tpl.substr(51);
+    PoaConfig config(PoaConfig::LOCAL_ALIGNMENT);
+
+    PoaGraph graph;
+    for (int k = 0; k < 3; k++)
+    {
+        graph.AddSequence(reads[k], config);
+    }
+    consensusSequence(graph, config);
+    std::stringstream buffer;
+    graph.Save(buffer);
+
+    // The loaded graph is the same graph...
+    PoaGraph loaded;
+    loaded.AddSequence("GATTACA", config);
+    loaded.Load(buffer);
+    EXPECT_EQ(3, loaded.NumSequences());
+    EXPECT_EQ(graph.ToGraphViz(PoaGraph::COLOR_NODES | PoaGraph::VERBOSE_NODES),
+              loaded.ToGraphViz(PoaGraph::COLOR_NODES | PoaGraph::VERBOSE_NODES));
+
+    // ... and grows as the original does
+    for (int k = 3; k < 5; k++)
+    {
+        graph.AddSequence(reads[k], config);
+        loaded.AddSequence(reads[k], config);
+    }
+    EXPECT_EQ(graph.ToGraphViz(), loaded.ToGraphViz());
+    EXPECT_EQ(consensusSequence(graph, config), consensusSequence(loaded, config));
+
+    // Bad input leaves the graph as it was
+    string dot = loaded.ToGraphViz();
+    std::stringstream notAGraph("GATTACA");
+    EXPECT_THROW(loaded.Load(notAGraph), InvalidInputError);
+    std::stringstream truncated(buffer.str().substr(0, buffer.str().length() / 2));
+    EXPECT_THROW(loaded.Load(truncated), InvalidInputError);
+    // (a sentinel base on an ordinary vertex)
+    string corrupt = buffer.str();
+    corrupt[12 + 2 * 18] = '^';
+    std::stringstream badBase(corrupt);
+    EXPECT_THROW(loaded.Load(badBase), InvalidInputError);
+    // (a sequence length far beyond the end of the input)
+    corrupt = buffer.str();
+    corrupt.replace(corrupt.length() - reads[2].length() - 4, 4, "\xff\xff\xff\x7f");
+    std::stringstream badLength(corrupt);
+    EXPECT_THROW(loaded.Load(badLength), InvalidInputError);
+    EXPECT_EQ(dot, loaded.ToGraphViz());
+
+    // Every vertex must lie on a path from ^ to $: here the graph of
+    // one base, ^ -> A -> $, loses one of its two edges
+    PoaGraph single;
+    single.AddSequence("A", config);
+    std::stringstream singleBuffer;
+    single.Save(singleBuffer);
+    // (magic, version, vertex count, 3 vertices, 3 order entries)
+    const int edgesAt = 12 + 3 * 18 + 3 * 4;
+    corrupt = singleBuffer.str();
+    ASSERT_EQ(string("\x02\0\0\0", 4), corrupt.substr(edgesAt, 4));
+    corrupt.replace(edgesAt, 4 + 2 * 8, string("\x01\0\0\0", 4) + corrupt.substr(edgesAt + 4, 8));
+    std::stringstream dangling(corrupt);
+    EXPECT_THROW(loaded.Load(dangling), InvalidInputError);
+    EXPECT_EQ(dot, loaded.ToGraphViz());
+
+    // The empty graph round-trips
+    PoaGraph empty, emptyLoaded;
+    std::stringstream emptyBuffer;
+    empty.Save(emptyBuffer);
+    emptyLoaded.Load(emptyBuffer);
+    EXPECT_EQ(0, emptyLoaded.NumSequences());
+
+    // Failing to write a file throws
+    EXPECT_THROW(graph.WriteBinaryFile("/nonexistent-directory/graph.poa"), InvalidInputError);
+}
@@ -0,0 +1,117 @@
+// Copyright (c) 2011, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE CONSTITUTES AND EMBODIES PACIFIC BIOSCIENCES' CONFIDENTIAL
+// AND PROPRIETARY INFORMATION.
+//
+// Disclosure, redistribution and use of this software is subject to the
+// terms and conditions of the applicable written agreement(s) between you
+// and Pacific Biosciences, where "you" refers to you or your company or
+// organization, as applicable.  Any other disclosure, redistribution or
+// use is prohibited.
+//
+// THIS SOFTWARE IS PROVIDED BY PACIFIC BIOSCIENCES AND ITS CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <gtest/gtest.h>
+#include <boost/assign.hpp>
+#include <string>
+#include <vector>
+
+#include "Mutation.hpp"
+#include "Sequence.hpp"
+#include "Quiver/MultiReadMutationScorer.hpp"
+#include "Quiver/PBFeatures.hpp"
+#include "Quiver/QuiverConfig.hpp"
+#include "Quiver/QuiverRefiner.hpp"
+#include "Quiver/SseRecursor.hpp"
+
+#include "ParameterSettings.hpp"
+
+using namespace ConsensusCore;  // NOLINT
+using namespace boost::assign;  // NOLINT
+
+typedef SparseSseQvMultiReadMutationScorer MMS;
+typedef SparseSseQvQuiverRefiner Refiner;
+
+static QuiverConfig TestingConfig(int numThreads = 1)
+{
+    return QuiverConfig(TestingParams<QvModelParams>(), ALL_MOVES,
+                        BandingOptions(4, 200), -500, false, numThreads);
+}
+
+static void AddTruthReads(MMS* mScorer, const std::string& truth)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        mScorer->AddRead(QvSequenceFeatures(truth), FORWARD_STRAND);
+        mScorer->AddRead(QvSequenceFeatures(ReverseComplement(truth)), REVERSE_STRAND);
+    }
+}
+
+
+TEST(QuiverRefinerTest, RefineTest)
+{
+    //                   0123456789012345678901234567890123456789
+    std::string truth = "AATGTAATCAATTGATTACATTGCAGTCCATGGATTACAG";
+    // Missing T at 12, substitution at 24, extra G after 35
+    std::string tpl   = "AATGTAATCAATGATTACATTGCTGTCCATGGATTGACAG";
+    MMS mScorer(TestingConfig(), tpl);
+    AddTruthReads(&mScorer, truth);
+
+    Refiner refiner(mScorer);
+    EXPECT_TRUE(refiner.Refine());
+    EXPECT_TRUE(refiner.Converged());
+    EXPECT_EQ(truth, mScorer.Template());
+    EXPECT_EQ(3, refiner.NumMutationsApplied());
+    EXPECT_EQ(2, refiner.NumIterations());
+
+    // Refining the truth again changes nothing.
+    EXPECT_TRUE(refiner.Refine());
+    EXPECT_EQ(0, refiner.NumMutationsApplied());
+    EXPECT_EQ(1, refiner.NumIterations());
+}
+
+
+TEST(QuiverRefinerTest, SeparationTest)
+{
+    //                   0123456789012345678901234567890123456789
+    std::string truth = "AATGTAATCAATTGATTACATTGCAGTCCATGGATTACAG";
+    std::string tpl   = "AATGTAATCAATTGCTTAGATTGCAGTCCATGGATTACAG";
+
+    // The errors are too close together to be fixed in one round.
+    MMS mScorer(TestingConfig(), tpl);
+    AddTruthReads(&mScorer, truth);
+    Refiner refiner(mScorer, RefineOptions(40, 10));
+    EXPECT_TRUE(refiner.Refine());
+    EXPECT_EQ(truth, mScorer.Template());
+    EXPECT_EQ(2, refiner.NumMutationsApplied());
+    EXPECT_EQ(3, refiner.NumIterations());
+
+    // Out of rounds before converging.
+    MMS mScorer2(TestingConfig(), tpl);
+    AddTruthReads(&mScorer2, truth);
+    Refiner refiner2(mScorer2, RefineOptions(1, 10));
+    EXPECT_FALSE(refiner2.Refine());
+    EXPECT_FALSE(refiner2.Converged());
+    EXPECT_EQ(1, refiner2.NumMutationsApplied());
+
+    // With less separation both are fixed at once.
+    MMS mScorer3(TestingConfig(2), tpl);
+    AddTruthReads(&mScorer3, truth);
+    Refiner refiner3(mScorer3, RefineOptions(40, 2));
+    EXPECT_TRUE(refiner3.Refine());
+    EXPECT_EQ(truth, mScorer3.Template());
+    EXPECT_EQ(2, refiner3.NumIterations());
+}
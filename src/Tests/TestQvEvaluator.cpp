@@ -143,3 +143,30 @@ TEST_F(QvEvaluatorTest, BadTagTest)
     ASSERT_THROW(f = new QvSequenceFeatures(seq, insQv, subsQv, delQv, delTag, mergeQv),
                  InternalError);
 }
+
+
+TEST_F(QvEvaluatorTest, TemplateViewTest)
+{
+    // An evaluator on a window of a shared template buffer behaves just
+    // like one holding a copy of that window.
+    boost::shared_ptr<const std::string> buffer(new std::string("CCCGATTACAGGG"));
+    QvSequenceFeatures read("GATTTACA");
+    QvModelParams params = TestingParams<QvModelParams>();
+    QvEvaluator viewEv(read, TemplateView(buffer, 3, 7), params);
+    QvEvaluator copyEv(read, std::string("GATTACA"), params);
+
+    EXPECT_EQ("GATTACA", viewEv.Template());
+    ASSERT_EQ(copyEv.TemplateLength(), viewEv.TemplateLength());
+    for (int j = 0; j < viewEv.TemplateLength(); j++)
+        for (int i = 0; i < viewEv.ReadLength(); i++)
+        {
+            EXPECT_EQ(copyEv.Inc(i, j), viewEv.Inc(i, j));
+            EXPECT_EQ(copyEv.Del(i, j), viewEv.Del(i, j));
+            EXPECT_EQ(copyEv.Extra(i, j), viewEv.Extra(i, j));
+        }
+
+    // Replacing the template does not touch the shared buffer.
+    viewEv.Template("GATTTACA");
+    EXPECT_EQ("GATTTACA", viewEv.Template());
+    EXPECT_EQ("CCCGATTACAGGG", *buffer);
+}
@@ -158,6 +158,12 @@ TYPED_TEST(RecursorTest, SmallMergeTest)
     EXPECT_EQ("GATT", alignment->Target());
     EXPECT_EQ("GA-T", alignment->Query());
 
+    std::vector<Move> moves = recursor.Traceback(e, alpha);
+    ASSERT_EQ(3, moves.size());
+    EXPECT_EQ(INCORPORATE, moves[0]);
+    EXPECT_EQ(INCORPORATE, moves[1]);
+    EXPECT_EQ(MERGE, moves[2]);
+
     // Make sure Beta gave the same score
     EXPECT_FLOAT_EQ(-2.0f, beta(0, 0));
     //    std::cout << std::endl;
@@ -244,6 +250,33 @@ TYPED_TEST(RecursorTest, ExtendTest)
     }
 }
 
+TYPED_TEST(RecursorTest, MultiColumnExtendTest)
+{
+    std::string tpl("GATTCTCAGGATC");
+    QvSequenceFeatures read("GATCTTCAGATC");
+    E e(read, tpl, this->testingParams_);
+
+    R recursor(BASIC_MOVES | MERGE, this->noBanding_);
+    M alpha(read.Length() + 1, tpl.length() + 1);
+    M beta(read.Length() + 1, tpl.length() + 1);
+    recursor.FillAlphaBeta(e, alpha, beta);
+
+    const int numExtColumns = 5;
+    M ext(read.Length() + 1, numExtColumns);
+    for (int j = 2; j + numExtColumns <= tpl.length() + 1; j++)
+    {
+        recursor.ExtendAlpha(e, alpha, j, ext, numExtColumns);
+        for (int extCol = 0; extCol < numExtColumns; extCol++)
+        {
+            for (int i = 0; i <= read.Length(); i++)
+            {
+                ASSERT_FLOAT_EQ(alpha(i, j + extCol), ext(i, extCol))
+                        << i << " " << j << " " << extCol << std::endl;
+            }
+        }
+    }
+}
+
 
 // ----------------------------------------------------------------------------
 // Fuzz tests --- testing applied to several hundred random templates and reads